@@ -3,6 +3,8 @@
 // license is apparently BSD (original includes no stated license)
 //
 
+#import "MGRGBA.h"
+
 #define RGB(r,g,b) [UIColor colorWithRed:r/255.0 green:g/255.0 blue:b/255.0 alpha:1]
 #define RGBA(r,g,b,a) [UIColor colorWithRed:r/255.0 green:g/255.0 blue:b/255.0 alpha:a]
 #define GREY(w,a) [UIColor colorWithWhite:w alpha:a]
@@ -28,6 +30,10 @@
 @property (nonatomic, readonly) CGFloat brightness;
 @property (nonatomic, readonly) UInt32 rgbHex;
 
+// The components as a value, for doing many operations without making a
+// UIColor for each. See MGRGBA.h
+@property (nonatomic, readonly) MGRGBA rgba;
+
 - (NSString *)colorSpaceString;
 - (NSArray *)arrayFromRGBAComponents;
 
@@ -63,7 +69,15 @@
 + (UIColor *)randomColor;
 + (UIColor *)semiRandomColor;
 + (UIColor *)colorWithString:(NSString *)stringToConvert;
+
+// "#rgb", "#rgba", "#rrggbb", "#rrggbbaa", "rgb()", "rgba()", "hsl()",
+// "hsla()", css color names, "transparent", and "{r, g, b, a}" / "{w, a}".
+// Safe to call from any thread. Repeated strings return the same instance
++ (UIColor *)colorWithCSSString:(NSString *)string;
+
 + (UIColor *)colorWithRGBHex:(UInt32)hex;
++ (UIColor *)colorWithRGBA:(MGRGBA)rgba;
++ (NSArray *)colorsWithRGBA:(const MGRGBA *)colors count:(NSUInteger)count;
 + (UIColor *)colorWithHexString:(NSString *)hexString;
 + (UIColor *)colorWithName:(NSString *)cssColorName;
 
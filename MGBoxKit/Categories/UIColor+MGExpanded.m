@@ -4,6 +4,7 @@
 //
 
 #import "UIColor+MGExpanded.h"
+#import "MGMemoryBudget.h"
 
 #define EPSILON     0.001f
 #define MIN3(x,y,z) ((y) <= (z) ? ((x) <= (y) ? (x) : (y)) : ((x) <= (z) ? (x) : (z)))
@@ -12,9 +13,6 @@
 #define SQRT3       1.732050807568877f
 #define CLAMP(x,low,high) (((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x)))
 
-// Static cache of looked up color names. Used with +colorWithName:
-static NSMutableDictionary *colorNameCache = nil;
-
 #if SUPPORTS_UNDOCUMENTED_API
 // Undocumented methods of UIColor+MGExpanded
 @interface UIColor+MGExpanded (Undocumented)
@@ -27,9 +25,60 @@ static NSMutableDictionary *colorNameCache = nil;
 @interface UIColor (Expanded_Support)
 
 + (UIColor *)searchForColorByName:(NSString *)cssColorName;
++ (UIColor *)searchForColorByCString:(const char *)name;
+
+@end
+
+@interface UIColor (Expanded_Parsing)
+
++ (UIColor *)colorByParsingString:(NSString *)string;
 
 @end
 
+// colour strings longer than this aren't parsed
+#define MG_COLOR_STRING_MAX_LENGTH 128
+
+// The string's UTF-8 bytes, straight from its storage when possible, otherwise
+// copied into the given stack buffer. Nothing is allocated
+static const char *MGColorStringBytes(NSString *string,
+    char buffer[MG_COLOR_STRING_MAX_LENGTH], size_t *length) {
+  if (!string) {
+    return NULL;
+  }
+  const char *bytes = CFStringGetCStringPtr((__bridge CFStringRef)string,
+      kCFStringEncodingUTF8);
+  if (!bytes) {
+    if (![string getCString:buffer maxLength:MG_COLOR_STRING_MAX_LENGTH
+        encoding:NSUTF8StringEncoding]) {
+      return NULL;
+    }
+    bytes = buffer;
+  }
+  *length = strlen(bytes);
+  return *length < MG_COLOR_STRING_MAX_LENGTH ? bytes : NULL;
+}
+
+static inline BOOL MGIsColorSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static inline int MGHexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c |= 0x20;
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static BOOL MGGetRGBA(UIColor *color, MGRGBA *rgba) {
+  CGFloat r, g, b, a;
+  if (![color red:&r green:&g blue:&b alpha:&a]) {
+    return NO;
+  }
+  *rgba = MGRGBAMake(r, g, b, a);
+  return YES;
+}
+
 #pragma mark -
 
 @implementation UIColor (MGExpanded)
@@ -170,6 +219,12 @@ static NSMutableDictionary *colorNameCache = nil;
       | (((int)roundf(b * 255)));
 }
 
+- (MGRGBA)rgba {
+  NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use rgba");
+  MGRGBA c;
+  return MGGetRGBA(self, &c) ? c : (MGRGBA)0;
+}
+
 - (BOOL)hue:(CGFloat *)hue saturation:(CGFloat *)saturation
  brightness:(CGFloat *)brightness alpha:(CGFloat *)alpha {
   if (hue) {
@@ -235,68 +290,69 @@ static NSMutableDictionary *colorNameCache = nil;
 
 #pragma mark Arithmetic operations
 
+// one conversion in, an MGRGBA operation, and one UIColor out
+
 - (UIColor *)colorByLuminanceMapping {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c;
+  if (!MGGetRGBA(self, &c)) {
     return nil;
   }
 
   // http://en.wikipedia.org/wiki/Luma_(video)
   // Y = 0.2126 R + 0.7152 G + 0.0722 B
-  return [UIColor colorWithWhite:r * 0.2126f + g * 0.7152f + b * 0.0722f alpha:a];
+  return [UIColor colorWithWhite:MGRGBALuminance(c) alpha:c.w];
 }
 
 - (UIColor *)colorByMultiplyingByRed:(CGFloat)red green:(CGFloat)green
                                 blue:(CGFloat)blue alpha:(CGFloat)alpha {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c;
+  if (!MGGetRGBA(self, &c)) {
     return nil;
   }
 
-  return [UIColor colorWithRed:CLAMP(r * red, 0, 1) green:CLAMP(g * green, 0, 1)
-      blue:CLAMP(b * blue, 0, 1) alpha:CLAMP(a * alpha, 0, 1)];
+  return [UIColor colorWithRGBA:MGRGBAMultiply(c,
+      MGRGBAMake(red, green, blue, alpha))];
 }
 
 - (UIColor *)colorByAddingRed:(CGFloat)red green:(CGFloat)green
                          blue:(CGFloat)blue alpha:(CGFloat)alpha {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c;
+  if (!MGGetRGBA(self, &c)) {
     return nil;
   }
-  return [UIColor colorWithRed:CLAMP(r + red, 0, 1) green:CLAMP(g + green, 0, 1)
-      blue:CLAMP(b + blue, 0, 1) alpha:CLAMP(a + alpha, 0, 1)];
+  return [UIColor colorWithRGBA:MGRGBAAdd(c, MGRGBAMake(red, green, blue, alpha))];
 }
 
 - (UIColor *)colorByLighteningToRed:(CGFloat)red green:(CGFloat)green
                                blue:(CGFloat)blue alpha:(CGFloat)alpha {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c;
+  if (!MGGetRGBA(self, &c)) {
     return nil;
   }
 
-  return [UIColor colorWithRed:MAX(r, red) green:MAX(g, green) blue:MAX(b, blue)
-      alpha:MAX(a, alpha)];
+  return [UIColor colorWithRGBA:MGRGBALighten(c,
+      MGRGBAMake(red, green, blue, alpha))];
 }
 
 - (UIColor *)colorByDarkeningToRed:(CGFloat)red green:(CGFloat)green
                               blue:(CGFloat)blue alpha:(CGFloat)alpha {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c;
+  if (!MGGetRGBA(self, &c)) {
     return nil;
   }
 
-  return [UIColor colorWithRed:MIN(r, red) green:MIN(g, green) blue:MIN(b, blue)
-      alpha:MIN(a, alpha)];
+  return [UIColor colorWithRGBA:MGRGBADarken(c,
+      MGRGBAMake(red, green, blue, alpha))];
 }
 
 - (UIColor *)colorByMultiplyingBy:(CGFloat)f {
@@ -322,45 +378,49 @@ static NSMutableDictionary *colorNameCache = nil;
 - (UIColor *)colorByMultiplyingByColor:(UIColor *)color {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c, by;
+  if (!MGGetRGBA(self, &c) || !MGGetRGBA(color, &by)) {
     return nil;
   }
+  by.w = 1;
 
-  return [self colorByMultiplyingByRed:r green:g blue:b alpha:1];
+  return [UIColor colorWithRGBA:MGRGBAMultiply(c, by)];
 }
 
 - (UIColor *)colorByAddingColor:(UIColor *)color {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c, add;
+  if (!MGGetRGBA(self, &c) || !MGGetRGBA(color, &add)) {
     return nil;
   }
+  add.w = 0;
 
-  return [self colorByAddingRed:r green:g blue:b alpha:0];
+  return [UIColor colorWithRGBA:MGRGBAAdd(c, add)];
 }
 
 - (UIColor *)colorByLighteningToColor:(UIColor *)color {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c, to;
+  if (!MGGetRGBA(self, &c) || !MGGetRGBA(color, &to)) {
     return nil;
   }
+  to.w = 0;
 
-  return [self colorByLighteningToRed:r green:g blue:b alpha:0];
+  return [UIColor colorWithRGBA:MGRGBALighten(c, to)];
 }
 
 - (UIColor *)colorByDarkeningToColor:(UIColor *)color {
   NSAssert(self.canProvideRGBComponents, @"Must be a RGB color to use arithmatic operations");
 
-  CGFloat r, g, b, a;
-  if (![self red:&r green:&g blue:&b alpha:&a]) {
+  MGRGBA c, to;
+  if (!MGGetRGBA(self, &c) || !MGGetRGBA(color, &to)) {
     return nil;
   }
+  to.w = 1;
 
-  return [self colorByDarkeningToRed:r green:g blue:b alpha:1];
+  return [UIColor colorWithRGBA:MGRGBADarken(c, to)];
 }
 
 - (UIColor *)colorByAddingHue:(CGFloat)hue saturation:(CGFloat)saturation
@@ -400,49 +460,14 @@ static NSMutableDictionary *colorNameCache = nil;
   return [NSString stringWithFormat:@"%0.6x", (unsigned int)self.rgbHex];
 }
 
+// Accepts "{r, g, b, a}" and "{w, a}", as made by -stringFromColor, and all the
+// forms accepted by +colorWithCSSString:
 + (UIColor *)colorWithString:(NSString *)stringToConvert {
-  NSScanner *scanner = [NSScanner scannerWithString:stringToConvert];
-  if (![scanner scanString:@"{" intoString:NULL]) {
-    return nil;
-  }
-  const NSUInteger kMaxComponents = 4;
-  float c[kMaxComponents];
-  NSUInteger i = 0;
-  if (![scanner scanFloat:&c[i++]]) {
-    return nil;
-  }
-  while (1) {
-    if ([scanner scanString:@"}" intoString:NULL]) {
-      break;
-    }
-    if (i >= kMaxComponents) {
-      return nil;
-    }
-    if ([scanner scanString:@"," intoString:NULL]) {
-      if (![scanner scanFloat:&c[i++]]) {
-        return nil;
-      }
-    } else {
-      // either we're at the end of there's an unexpected character here
-      // both cases are error conditions
-      return nil;
-    }
-  }
-  if (![scanner isAtEnd]) {
-    return nil;
-  }
-  UIColor *color;
-  switch (i) {
-    case 2: // monochrome
-      color = [UIColor colorWithWhite:c[0] alpha:c[1]];
-      break;
-    case 4: // RGB
-      color = [UIColor colorWithRed:c[0] green:c[1] blue:c[2] alpha:c[3]];
-      break;
-    default:
-      color = nil;
-  }
-  return color;
+  return [self colorByParsingString:stringToConvert];
+}
+
++ (UIColor *)colorWithCSSString:(NSString *)string {
+  return [self colorByParsingString:string];
 }
 
 #pragma mark Class methods
@@ -467,48 +492,49 @@ static NSMutableDictionary *colorNameCache = nil;
   return [UIColor colorWithRed:r / 255.0 green:g / 255.0 blue:b / 255.0 alpha:1];
 }
 
++ (UIColor *)colorWithRGBA:(MGRGBA)rgba {
+  return [UIColor colorWithRed:rgba.x green:rgba.y blue:rgba.z alpha:rgba.w];
+}
+
++ (NSArray *)colorsWithRGBA:(const MGRGBA *)colors count:(NSUInteger)count {
+  NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger i = 0; i < count; i++) {
+    [result addObject:[UIColor colorWithRGBA:colors[i]]];
+  }
+  return result;
+}
+
 // Returns a UIColor by scanning the string for a hex number and passing that to +[UIColor+MGExpanded colorWithRGBHex:]
 // Skips any leading whitespace and ignores any trailing characters
 + (UIColor *)colorWithHexString:(NSString *)hexString {
-  NSString *clean = [hexString stringByReplacingOccurrencesOfString:@"#"
-      withString:@""];
-  NSScanner *scanner = [NSScanner scannerWithString:clean];
-  unsigned hexNum;
-  if (![scanner scanHexInt:&hexNum]) {
+  char buffer[MG_COLOR_STRING_MAX_LENGTH];
+  size_t length;
+  const char *bytes = MGColorStringBytes(hexString, buffer, &length);
+  if (!bytes) {
+    return nil;
+  }
+  const char *c = bytes, *end = bytes + length;
+  while (c < end && (MGIsColorSpace(*c) || *c == '#')) {
+    c++;
+  }
+  if (end - c > 2 && c[0] == '0' && (c[1] | 0x20) == 'x') {
+    c += 2;
+  }
+  UInt32 hexNum = 0;
+  const char *digits = c;
+  for (int digit; c < end && (digit = MGHexDigit(*c)) >= 0; c++) {
+    hexNum = (hexNum << 4) | digit;
+  }
+  if (c == digits) {
     return nil;
   }
   return [UIColor colorWithRGBHex:hexNum];
 }
 
-// Lookup a color using css 3/svg color name
+// Lookup a color using css 3/svg color name. Lock free, so safe to call from
+// any thread
 + (UIColor *)colorWithName:(NSString *)cssColorName {
-  UIColor *color;
-  @synchronized (colorNameCache) {
-
-    // Look for the color in the cache
-    color = colorNameCache[cssColorName];
-
-    if ((id)color == NSNull.null) {
-      // If it wasn't there previously, it's still not there now
-      color = nil;
-
-    } else if (!color) {
-
-      // Color not in cache, so search for it now
-      color = [self searchForColorByName:cssColorName];
-
-      // Set the value in cache, storing NSNull on failure
-      colorNameCache[cssColorName] = (color ? : (id)[NSNull null]);
-    }
-  }
-
-  return color;
-}
-
-#pragma mark UIColor_Expanded initialization
-
-+ (void)load {
-  colorNameCache = [[NSMutableDictionary alloc] init];
+  return [self searchForColorByName:cssColorName];
 }
 
 @end
@@ -548,73 +574,519 @@ static NSMutableDictionary *colorNameCache = nil;
 @implementation UIColor (Expanded_Support)
 
 /*
-* Database of color names and hex rgb values, derived
-* from the css 3 color spec:
+* Color names and hex rgb values from the css 3 color spec:
 *	http://www.w3.org/TR/css3-color/
 *
-* We think this is a very compact way of storing
-* this information, and relatively cheap to lookup.
-*
-* Note that we search for color names starting with ','
-* and terminated by '#', so that we don't get false matches.
-* For this reason, the database begins with ','.
+* Stored as a perfect hash table, generated ahead of time. A name's bucket is
+* MGColorNameHash(name, 0) % 64, and its slot is
+* MGColorNameHash(name, MGColorNameDisplacements[bucket]) % 256. Every name
+* lands in its own slot, so a lookup is two hashes and one string compare, with
+* no locks or allocations. To add a name, find new displacements for the
+* buckets that change.
 */
-static const char *colorNameDB = ","
-    "aliceblue#f0f8ff,antiquewhite#faebd7,aqua#00ffff,aquamarine#7fffd4,azure#f0ffff,"
-    "beige#f5f5dc,bisque#ffe4c4,black#000000,blanchedalmond#ffebcd,blue#0000ff,"
-    "blueviolet#8a2be2,brown#a52a2a,burlywood#deb887,cadetblue#5f9ea0,chartreuse#7fff00,"
-    "chocolate#d2691e,coral#ff7f50,cornflowerblue#6495ed,cornsilk#fff8dc,crimson#dc143c,"
-    "cyan#00ffff,darkblue#00008b,darkcyan#008b8b,darkgoldenrod#b8860b,darkgray#a9a9a9,"
-    "darkgreen#006400,darkgrey#a9a9a9,darkkhaki#bdb76b,darkmagenta#8b008b,"
-    "darkolivegreen#556b2f,darkorange#ff8c00,darkorchid#9932cc,darkred#8b0000,"
-    "darksalmon#e9967a,darkseagreen#8fbc8f,darkslateblue#483d8b,darkslategray#2f4f4f,"
-    "darkslategrey#2f4f4f,darkturquoise#00ced1,darkviolet#9400d3,deeppink#ff1493,"
-    "deepskyblue#00bfff,dimgray#696969,dimgrey#696969,dodgerblue#1e90ff,"
-    "firebrick#b22222,floralwhite#fffaf0,forestgreen#228b22,fuchsia#ff00ff,"
-    "gainsboro#dcdcdc,ghostwhite#f8f8ff,gold#ffd700,goldenrod#daa520,gray#808080,"
-    "green#008000,greenyellow#adff2f,grey#808080,honeydew#f0fff0,hotpink#ff69b4,"
-    "indianred#cd5c5c,indigo#4b0082,ivory#fffff0,khaki#f0e68c,lavender#e6e6fa,"
-    "lavenderblush#fff0f5,lawngreen#7cfc00,lemonchiffon#fffacd,lightblue#add8e6,"
-    "lightcoral#f08080,lightcyan#e0ffff,lightgoldenrodyellow#fafad2,lightgray#d3d3d3,"
-    "lightgreen#90ee90,lightgrey#d3d3d3,lightpink#ffb6c1,lightsalmon#ffa07a,"
-    "lightseagreen#20b2aa,lightskyblue#87cefa,lightslategray#778899,"
-    "lightslategrey#778899,lightsteelblue#b0c4de,lightyellow#ffffe0,lime#00ff00,"
-    "limegreen#32cd32,linen#faf0e6,magenta#ff00ff,maroon#800000,mediumaquamarine#66cdaa,"
-    "mediumblue#0000cd,mediumorchid#ba55d3,mediumpurple#9370db,mediumseagreen#3cb371,"
-    "mediumslateblue#7b68ee,mediumspringgreen#00fa9a,mediumturquoise#48d1cc,"
-    "mediumvioletred#c71585,midnightblue#191970,mintcream#f5fffa,mistyrose#ffe4e1,"
-    "moccasin#ffe4b5,navajowhite#ffdead,navy#000080,oldlace#fdf5e6,olive#808000,"
-    "olivedrab#6b8e23,orange#ffa500,orangered#ff4500,orchid#da70d6,palegoldenrod#eee8aa,"
-    "palegreen#98fb98,paleturquoise#afeeee,palevioletred#db7093,papayawhip#ffefd5,"
-    "peachpuff#ffdab9,peru#cd853f,pink#ffc0cb,plum#dda0dd,powderblue#b0e0e6,"
-    "purple#800080,red#ff0000,rosybrown#bc8f8f,royalblue#4169e1,saddlebrown#8b4513,"
-    "salmon#fa8072,sandybrown#f4a460,seagreen#2e8b57,seashell#fff5ee,sienna#a0522d,"
-    "silver#c0c0c0,skyblue#87ceeb,slateblue#6a5acd,slategray#708090,slategrey#708090,"
-    "snow#fffafa,springgreen#00ff7f,steelblue#4682b4,tan#d2b48c,teal#008080,"
-    "thistle#d8bfd8,tomato#ff6347,turquoise#40e0d0,violet#ee82ee,wheat#f5deb3,"
-    "white#ffffff,whitesmoke#f5f5f5,yellow#ffff00,yellowgreen#9acd32";
+typedef struct {
+  const char *name;
+  UInt32 rgb;
+} MGNamedColor;
+
+#define MG_COLOR_NAME_BUCKETS 64
+#define MG_COLOR_NAME_SLOTS 256
+
+// longest name is "lightgoldenrodyellow"
+#define MG_COLOR_NAME_MAX_LENGTH 32
+
+static const uint16_t MGColorNameDisplacements[64] = {
+    0, 0, 0, 6, 1, 2, 1, 0, 2, 1, 2, 0,
+    2, 1, 2, 2, 4, 1, 3, 2, 2, 3, 1, 2,
+    4, 2, 1, 0, 2, 1, 1, 3, 3, 0, 1, 0,
+    4, 0, 1, 2, 1, 2, 1, 1, 1, 5, 1, 1,
+    5, 3, 5, 3, 8, 1, 1, 3, 0, 5, 1, 1,
+    1, 5, 1, 14
+};
+
+static const MGNamedColor MGNamedColors[256] = {
+    {"mediumpurple", 0x9370db}, {"aquamarine", 0x7fffd4}, {0}, {"darkgrey", 0xa9a9a9},
+    {"whitesmoke", 0xf5f5f5}, {"lightgoldenrodyellow", 0xfafad2},
+    {"lightcoral", 0xf08080}, {0}, {"linen", 0xfaf0e6}, {"mediumturquoise", 0x48d1cc},
+    {"goldenrod", 0xdaa520}, {"coral", 0xff7f50}, {0}, {"fuchsia", 0xff00ff},
+    {"thistle", 0xd8bfd8}, {0}, {"darkseagreen", 0x8fbc8f}, {0}, {0},
+    {"lightsteelblue", 0xb0c4de}, {"darkblue", 0x00008b}, {0}, {"darkred", 0x8b0000},
+    {0}, {"blueviolet", 0x8a2be2}, {"purple", 0x800080}, {0}, {"lightsalmon", 0xffa07a},
+    {"wheat", 0xf5deb3}, {"lime", 0x00ff00}, {"palevioletred", 0xdb7093}, {0}, {0},
+    {"lemonchiffon", 0xfffacd}, {"khaki", 0xf0e68c}, {0}, {0}, {0}, {0}, {0},
+    {"slategray", 0x708090}, {"darkturquoise", 0x00ced1}, {0},
+    {"greenyellow", 0xadff2f}, {"darksalmon", 0xe9967a}, {"dimgrey", 0x696969}, {0},
+    {"chocolate", 0xd2691e}, {0}, {"rosybrown", 0xbc8f8f}, {0}, {0}, {0},
+    {"firebrick", 0xb22222}, {"olivedrab", 0x6b8e23}, {"dodgerblue", 0x1e90ff}, {0},
+    {"saddlebrown", 0x8b4513}, {"olive", 0x808000}, {0}, {0}, {0},
+    {"mediumaquamarine", 0x66cdaa}, {0}, {0}, {0}, {0}, {0}, {0}, {0}, {0}, {0},
+    {"skyblue", 0x87ceeb}, {"lightskyblue", 0x87cefa}, {"indianred", 0xcd5c5c},
+    {"palegoldenrod", 0xeee8aa}, {0}, {0}, {"mediumseagreen", 0x3cb371},
+    {"bisque", 0xffe4c4}, {0}, {"white", 0xffffff}, {0}, {"lavender", 0xe6e6fa}, {0},
+    {"turquoise", 0x40e0d0}, {"plum", 0xdda0dd}, {"sandybrown", 0xf4a460},
+    {"ghostwhite", 0xf8f8ff}, {0}, {0}, {"slategrey", 0x708090}, {"teal", 0x008080},
+    {0}, {"lightcyan", 0xe0ffff}, {"grey", 0x808080}, {"lightyellow", 0xffffe0}, {0},
+    {"yellowgreen", 0x9acd32}, {"violet", 0xee82ee}, {"paleturquoise", 0xafeeee}, {0},
+    {0}, {0}, {"navy", 0x000080}, {"springgreen", 0x00ff7f}, {0}, {"gray", 0x808080},
+    {"pink", 0xffc0cb}, {0}, {0}, {0}, {0}, {"ivory", 0xfffff0}, {0}, {0},
+    {"mediumblue", 0x0000cd}, {0}, {"cornflowerblue", 0x6495ed}, {"seashell", 0xfff5ee},
+    {0}, {"moccasin", 0xffe4b5}, {"blanchedalmond", 0xffebcd}, {"magenta", 0xff00ff},
+    {0}, {0}, {0}, {0}, {"deeppink", 0xff1493}, {"slateblue", 0x6a5acd},
+    {"beige", 0xf5f5dc}, {"darkorchid", 0x9932cc}, {"hotpink", 0xff69b4},
+    {"gold", 0xffd700}, {"palegreen", 0x98fb98}, {0}, {"blue", 0x0000ff}, {0}, {0}, {0},
+    {"darkolivegreen", 0x556b2f}, {0}, {"lightpink", 0xffb6c1}, {"darkcyan", 0x008b8b},
+    {"brown", 0xa52a2a}, {"azure", 0xf0ffff}, {"mistyrose", 0xffe4e1}, {0},
+    {"darkslategray", 0x2f4f4f}, {"orangered", 0xff4500}, {0}, {"darkviolet", 0x9400d3},
+    {"gainsboro", 0xdcdcdc}, {0}, {"indigo", 0x4b0082}, {"darkgreen", 0x006400}, {0},
+    {0}, {0}, {0}, {"black", 0x000000}, {"crimson", 0xdc143c}, {"peachpuff", 0xffdab9},
+    {"royalblue", 0x4169e1}, {"seagreen", 0x2e8b57}, {"mediumspringgreen", 0x00fa9a},
+    {"steelblue", 0x4682b4}, {"papayawhip", 0xffefd5}, {0}, {"cadetblue", 0x5f9ea0},
+    {0}, {"cornsilk", 0xfff8dc}, {"mintcream", 0xf5fffa}, {"mediumslateblue", 0x7b68ee},
+    {"red", 0xff0000}, {"burlywood", 0xdeb887}, {"mediumorchid", 0xba55d3},
+    {"navajowhite", 0xffdead}, {"darkorange", 0xff8c00}, {0},
+    {"midnightblue", 0x191970}, {0}, {"lavenderblush", 0xfff0f5}, {0}, {0},
+    {"lightslategray", 0x778899}, {0}, {0}, {0}, {0}, {"orange", 0xffa500},
+    {"darkmagenta", 0x8b008b}, {0}, {0}, {0}, {"darkslategrey", 0x2f4f4f},
+    {"yellow", 0xffff00}, {0}, {0}, {0}, {0}, {"antiquewhite", 0xfaebd7},
+    {"oldlace", 0xfdf5e6}, {0}, {"chartreuse", 0x7fff00}, {"darkslateblue", 0x483d8b},
+    {0}, {0}, {"lightslategrey", 0x778899}, {0}, {0}, {"cyan", 0x00ffff},
+    {"honeydew", 0xf0fff0}, {"peru", 0xcd853f}, {"darkkhaki", 0xbdb76b},
+    {"lightgray", 0xd3d3d3}, {"salmon", 0xfa8072}, {0}, {0},
+    {"mediumvioletred", 0xc71585}, {"floralwhite", 0xfffaf0}, {0}, {0}, {0},
+    {"lightseagreen", 0x20b2aa}, {"tomato", 0xff6347}, {0}, {"deepskyblue", 0x00bfff},
+    {0}, {"powderblue", 0xb0e0e6}, {0}, {0}, {0}, {"lawngreen", 0x7cfc00}, {0},
+    {"snow", 0xfffafa}, {"tan", 0xd2b48c}, {"aliceblue", 0xf0f8ff},
+    {"sienna", 0xa0522d}, {"green", 0x008000}, {0}, {"dimgray", 0x696969},
+    {"lightgrey", 0xd3d3d3}, {"silver", 0xc0c0c0}, {"lightblue", 0xadd8e6},
+    {"forestgreen", 0x228b22}, {"darkgoldenrod", 0xb8860b}, {"darkgray", 0xa9a9a9}, {0},
+    {"limegreen", 0x32cd32}, {0}, {"lightgreen", 0x90ee90}, {"maroon", 0x800000}, {0},
+    {"aqua", 0x00ffff}, {"orchid", 0xda70d6}
+};
+
+// 32 bit FNV-1a, with the seed mixed into the offset basis
+static inline uint32_t MGColorNameHash(const char *name, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (const char *c = name; *c; c++) {
+    hash ^= (uint8_t)*c;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static NSInteger MGNamedColorSlot(const char *name) {
+  uint32_t bucket = MGColorNameHash(name, 0) % MG_COLOR_NAME_BUCKETS;
+  uint32_t slot = MGColorNameHash(name, MGColorNameDisplacements[bucket])
+      % MG_COLOR_NAME_SLOTS;
+  const char *found = MGNamedColors[slot].name;
+  return found && !strcmp(found, name) ? slot : NSNotFound;
+}
 
 + (UIColor *)searchForColorByName:(NSString *)cssColorName {
-  UIColor *result = nil;
-
-  // Compile the string we'll use to search against the database
-  // We search for ",<colorname>#" to avoid false matches
-  const char *searchString = [[NSString stringWithFormat:@",%@#", cssColorName]
-      UTF8String];
-
-  // Search for the color name
-  const char *found = strstr(colorNameDB, searchString);
-
-  // If found, step past the search string and grab the hex representation
-  if (found) {
-    const char *after = found + strlen(searchString);
-    int hex;
-    if (sscanf(after, "%x", &hex) == 1) {
-      result = [self colorWithRGBHex:hex];
+
+  // names are ascii, so copy into a stack buffer instead of converting
+  char name[MG_COLOR_NAME_MAX_LENGTH];
+  if (![cssColorName getCString:name maxLength:sizeof(name)
+      encoding:NSASCIIStringEncoding]) {
+    return nil;
+  }
+  return [self searchForColorByCString:name];
+}
+
++ (UIColor *)searchForColorByCString:(const char *)name {
+
+  // colors are made once, then shared
+  static UIColor *colors[MG_COLOR_NAME_SLOTS];
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    for (NSUInteger i = 0; i < MG_COLOR_NAME_SLOTS; i++) {
+      if (MGNamedColors[i].name) {
+        colors[i] = [self colorWithRGBHex:MGNamedColors[i].rgb];
+      }
     }
+  });
+
+  NSInteger slot = MGNamedColorSlot(name);
+  return slot == NSNotFound ? nil : colors[slot];
+}
+
+@end
+
+#pragma mark - Colour string parsing
+
+/*
+* One pass over a string's UTF-8 bytes, for "#rgb", "#rgba", "#rrggbb",
+* "#rrggbbaa", "rgb()", "rgba()", "hsl()", "hsla()", css names, and the
+* "{r, g, b, a}" and "{w, a}" forms made by -stringFromColor. Nothing is
+* allocated except the resulting UIColor, and results are interned in a small
+* fixed size cache, so repeated strings return the same instance.
+*/
+
+static inline void MGSkipColorSpaces(const char **c, const char *end) {
+  while (*c < end && MGIsColorSpace(**c)) {
+    (*c)++;
   }
+}
 
-  return result;
+// a plain decimal number, with optional sign, fraction, and percent sign.
+// no exponents, and no locale
+static BOOL MGScanColorNumber(const char **c, const char *end, CGFloat *value,
+      BOOL *percent) {
+  const char *p = *c;
+  BOOL negative = NO, digits = NO;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p++ == '-';
+  }
+  double result = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; p++, digits = YES) {
+    result = result * 10 + (*p - '0');
+  }
+  if (p < end && *p == '.') {
+    double scale = 0.1;
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits = YES) {
+      result += (*p - '0') * scale;
+      scale *= 0.1;
+    }
+  }
+  if (!digits) {
+    return NO;
+  }
+  *percent = p < end && *p == '%';
+  *value = negative ? -result : result;
+  *c = *percent ? p + 1 : p;
+  return YES;
+}
+
+static UIColor *MGColorFromHexBytes(const char *c, const char *end) {
+  long n = end - c;
+  if (n != 3 && n != 4 && n != 6 && n != 8) {
+    return nil;
+  }
+  UInt32 value = 0;
+  for (int digit; c < end; c++) {
+    if ((digit = MGHexDigit(*c)) < 0) {
+      return nil;
+    }
+    value = (value << 4) | digit;
+  }
+  CGFloat r, g, b, a = 1;
+  if (n <= 4) { // one digit per component, 0xf == 0xff
+    int shift = (int)(n - 1) * 4;
+    r = ((value >> shift) & 0xF) * 17 / 255.0;
+    g = ((value >> (shift - 4)) & 0xF) * 17 / 255.0;
+    b = ((value >> (shift - 8)) & 0xF) * 17 / 255.0;
+    if (n == 4) {
+      a = (value & 0xF) * 17 / 255.0;
+    }
+  } else {
+    int shift = (int)(n - 2) * 4;
+    r = ((value >> shift) & 0xFF) / 255.0;
+    g = ((value >> (shift - 8)) & 0xFF) / 255.0;
+    b = ((value >> (shift - 16)) & 0xFF) / 255.0;
+    if (n == 8) {
+      a = (value & 0xFF) / 255.0;
+    }
+  }
+  return [UIColor colorWithRed:r green:g blue:b alpha:a];
+}
+
+static CGFloat MGHueToRGB(CGFloat p, CGFloat q, CGFloat t) {
+  if (t < 0) {
+    t += 1;
+  }
+  if (t > 1) {
+    t -= 1;
+  }
+  if (t < 1.0 / 6) {
+    return p + (q - p) * 6 * t;
+  }
+  if (t < 0.5) {
+    return q;
+  }
+  if (t < 2.0 / 3) {
+    return p + (q - p) * (2.0 / 3 - t) * 6;
+  }
+  return p;
+}
+
+// rgb(), rgba(), hsl(), hsla(), with commas, or css 4 style spaces and a slash
+// before the alpha
+static UIColor *MGColorFromFunctionBytes(const char *c, const char *end) {
+  const char *name = c;
+  while (c < end && *c != '(') {
+    c++;
+  }
+  long nameLength = c - name;
+  if (nameLength != 3 && !(nameLength == 4 && (name[3] | 0x20) == 'a')) {
+    return nil;
+  }
+  BOOL hsl;
+  if (!strncasecmp(name, "rgb", 3)) {
+    hsl = NO;
+  } else if (!strncasecmp(name, "hsl", 3)) {
+    hsl = YES;
+  } else {
+    return nil;
+  }
+  if (c == end || end[-1] != ')') {
+    return nil;
+  }
+  c++, end--;
+
+  CGFloat v[4];
+  BOOL percent[4];
+  int count = 0;
+  MGSkipColorSpaces(&c, end);
+  while (YES) {
+    if (count == 4 || !MGScanColorNumber(&c, end, &v[count], &percent[count])) {
+      return nil;
+    }
+    if (hsl && !count && end - c >= 3 && !strncasecmp(c, "deg", 3)) {
+      c += 3;
+    }
+    count++;
+    MGSkipColorSpaces(&c, end);
+    if (c == end) {
+      break;
+    }
+    if (*c == ',' || *c == '/') {
+      c++;
+      MGSkipColorSpaces(&c, end);
+    }
+  }
+  if (count < 3) {
+    return nil;
+  }
+
+  CGFloat alpha = count < 4 ? 1 : percent[3] ? v[3] / 100 : v[3];
+  alpha = CLAMP(alpha, 0, 1);
+  if (hsl) {
+    CGFloat h = fmod(v[0], 360) / 360;
+    if (h < 0) {
+      h += 1;
+    }
+    CGFloat s = CLAMP(v[1] / 100, 0, 1), l = CLAMP(v[2] / 100, 0, 1);
+    CGFloat q = l < 0.5 ? l * (1 + s) : l + s - l * s, p = 2 * l - q;
+    return [UIColor colorWithRed:MGHueToRGB(p, q, h + 1.0 / 3)
+        green:MGHueToRGB(p, q, h) blue:MGHueToRGB(p, q, h - 1.0 / 3)
+        alpha:alpha];
+  }
+  CGFloat rgb[3];
+  for (int i = 0; i < 3; i++) {
+    rgb[i] = percent[i] ? v[i] / 100 : v[i] / 255;
+    rgb[i] = CLAMP(rgb[i], 0, 1);
+  }
+  return [UIColor colorWithRed:rgb[0] green:rgb[1] blue:rgb[2] alpha:alpha];
+}
+
+// "{r, g, b, a}" or "{w, a}", unclamped, as -colorWithString: always allowed
+static UIColor *MGColorFromBraceBytes(const char *c, const char *end) {
+  if (end[-1] != '}') {
+    return nil;
+  }
+  c++, end--;
+
+  CGFloat v[4];
+  BOOL percent;
+  int count = 0;
+  while (YES) {
+    MGSkipColorSpaces(&c, end);
+    if (count == 4 || !MGScanColorNumber(&c, end, &v[count++], &percent)
+        || percent) {
+      return nil;
+    }
+    MGSkipColorSpaces(&c, end);
+    if (c == end) {
+      break;
+    }
+    if (*c++ != ',') {
+      return nil;
+    }
+  }
+  switch (count) {
+    case 2:
+      return [UIColor colorWithWhite:v[0] alpha:v[1]];
+    case 4:
+      return [UIColor colorWithRed:v[0] green:v[1] blue:v[2] alpha:v[3]];
+    default:
+      return nil;
+  }
+}
+
+static UIColor *MGColorFromNameBytes(const char *c, const char *end) {
+  char name[MG_COLOR_NAME_MAX_LENGTH];
+  long length = end - c;
+  if (length >= (long)sizeof(name)) {
+    return nil;
+  }
+  for (long i = 0; i < length; i++) {
+    name[i] = c[i] >= 'A' && c[i] <= 'Z' ? c[i] | 0x20 : c[i];
+  }
+  name[length] = '\0';
+  if (!strcmp(name, "transparent")) {
+    return UIColor.clearColor;
+  }
+  return [UIColor searchForColorByCString:name];
+}
+
+static UIColor *MGColorFromBytes(const char *c, const char *end) {
+  MGSkipColorSpaces(&c, end);
+  while (end > c && MGIsColorSpace(end[-1])) {
+    end--;
+  }
+  if (c == end) {
+    return nil;
+  }
+  if (*c == '#') {
+    return MGColorFromHexBytes(c + 1, end);
+  }
+  if (*c == '{') {
+    return MGColorFromBraceBytes(c, end);
+  }
+  if (memchr(c, '(', end - c)) {
+    return MGColorFromFunctionBytes(c, end);
+  }
+  return MGColorFromNameBytes(c, end);
+}
+
+#pragma mark - Colour string interning
+
+// direct mapped by hash. a new string replaces whatever was in its slot
+#define MG_COLOR_CACHE_SLOTS 256
+
+// longer strings are parsed but not interned
+#define MG_COLOR_CACHE_KEY_LENGTH 40
+
+typedef struct {
+  uint32_t hash;
+  uint8_t length;
+  char key[MG_COLOR_CACHE_KEY_LENGTH];
+  CFTypeRef color;
+} MGCachedColor;
+
+// roughly the entry plus its UIColor
+#define MG_COLOR_CACHE_ENTRY_COST (sizeof(MGCachedColor) + 64)
+
+static inline uint32_t MGColorStringHash(const char *bytes, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+@interface MGColorStringCache : NSObject <MGTrimmableCache>
+
++ (instancetype)sharedCache;
+- (UIColor *)colorForBytes:(const char *)bytes length:(size_t)length;
+- (UIColor *)internColor:(UIColor *)color forBytes:(const char *)bytes
+      length:(size_t)length;
+
+@end
+
+@implementation MGColorStringCache {
+  MGCachedColor _entries[MG_COLOR_CACHE_SLOTS];
+  NSUInteger _count;
+}
+
++ (instancetype)sharedCache {
+  static MGColorStringCache *cache;
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    cache = [[self alloc] init];
+    [MGMemoryBudget.sharedBudget registerCache:cache];
+  });
+  return cache;
+}
+
+- (UIColor *)colorForBytes:(const char *)bytes length:(size_t)length {
+  if (length > MG_COLOR_CACHE_KEY_LENGTH) {
+    return nil;
+  }
+  uint32_t hash = MGColorStringHash(bytes, length);
+  UIColor *color = nil;
+  @synchronized (self) {
+    MGCachedColor *entry = &_entries[hash % MG_COLOR_CACHE_SLOTS];
+    if (entry->color && entry->hash == hash && entry->length == length
+        && !memcmp(entry->key, bytes, length)) {
+      color = (__bridge UIColor *)entry->color;
+    }
+  }
+  return color;
+}
+
+// returns the already interned colour if another thread got there first
+- (UIColor *)internColor:(UIColor *)color forBytes:(const char *)bytes
+      length:(size_t)length {
+  if (length > MG_COLOR_CACHE_KEY_LENGTH) {
+    return color;
+  }
+  uint32_t hash = MGColorStringHash(bytes, length);
+  @synchronized (self) {
+    MGCachedColor *entry = &_entries[hash % MG_COLOR_CACHE_SLOTS];
+    if (entry->color) {
+      if (entry->hash == hash && entry->length == length
+          && !memcmp(entry->key, bytes, length)) {
+        return (__bridge UIColor *)entry->color;
+      }
+      CFRelease(entry->color);
+    } else {
+      _count++;
+    }
+    entry->hash = hash;
+    entry->length = (uint8_t)length;
+    memcpy(entry->key, bytes, length);
+    entry->color = CFBridgingRetain(color);
+  }
+  [MGMemoryBudget.sharedBudget cacheDidGrow:self];
+  return color;
+}
+
+#pragma mark - MGTrimmableCache
+
+- (NSString *)cacheName {
+  return @"UIColor strings";
+}
+
+- (NSUInteger)cacheCost {
+  @synchronized (self) {
+    return _count * MG_COLOR_CACHE_ENTRY_COST;
+  }
+}
+
+- (void)trimToCost:(NSUInteger)cost {
+  @synchronized (self) {
+    if (_count * MG_COLOR_CACHE_ENTRY_COST <= cost) {
+      return;
+    }
+    for (NSUInteger i = 0; i < MG_COLOR_CACHE_SLOTS; i++) {
+      if (_entries[i].color) {
+        CFRelease(_entries[i].color);
+        _entries[i].color = NULL;
+      }
+    }
+    _count = 0;
+  }
+}
+
+@end
+
+@implementation UIColor (Expanded_Parsing)
+
++ (UIColor *)colorByParsingString:(NSString *)string {
+  char buffer[MG_COLOR_STRING_MAX_LENGTH];
+  size_t length;
+  const char *bytes = MGColorStringBytes(string, buffer, &length);
+  if (!bytes) {
+    return nil;
+  }
+  MGColorStringCache *cache = MGColorStringCache.sharedCache;
+  UIColor *color = [cache colorForBytes:bytes length:length];
+  if (color) {
+    return color;
+  }
+  color = MGColorFromBytes(bytes, bytes + length);
+  return color ? [cache internColor:color forBytes:bytes length:length] : nil;
 }
 
 @end
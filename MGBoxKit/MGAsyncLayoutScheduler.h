@@ -0,0 +1,61 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+@protocol MGLayoutBox;
+
+/**
+* Runs the [asyncLayout](-[MGLayoutBox asyncLayout]) and
+* [asyncLayoutOnce](-[MGLayoutBox asyncLayoutOnce]) blocks of boxes, with a
+* bounded number running at once.
+*
+* - Repeated layouts of the same box before its blocks run collapse into a
+*   single run. A layout while the blocks are running queues one more run.
+* - Boxes that are on screen run before boxes that aren't.
+* - Pending runs are dropped when a box is reused by a box provider, and held
+*   while a box is hidden or off window.
+*
+* Blocks still run on each box's [asyncQueue](-[MGLayoutBox asyncQueue]).
+*/
+
+@interface MGAsyncLayoutScheduler : NSObject
+
++ (instancetype)sharedScheduler;
+
+/**
+* The most blocks allowed to run at once. Default is the number of active
+* processor cores, or 2 if there are fewer.
+*/
+@property (nonatomic, assign) NSUInteger maxConcurrent;
+
+/** @name Scheduling */
+
+/**
+* Queues a run of the box's async blocks. Called at the end of
+* [layout](-[MGLayoutBox layout]). Must be called on the main thread.
+*/
+- (void)scheduleLayoutFor:(UIView <MGLayoutBox> *)box;
+
+/**
+* Drops any pending run for the box. A suspended box stays suspended until
+* <resumeLayoutFor:>, so a later run still waits for it to be visible.
+*/
+- (void)cancelLayoutFor:(UIView <MGLayoutBox> *)box;
+
+/**
+* Holds a pending run until <resumeLayoutFor:>, eg while the box is hidden.
+*/
+- (void)suspendLayoutFor:(UIView <MGLayoutBox> *)box;
+- (void)resumeLayoutFor:(UIView <MGLayoutBox> *)box;
+
+/** @name Stats */
+
+@property (nonatomic, readonly) NSUInteger pendingCount;
+@property (nonatomic, readonly) NSUInteger runningCount;
+
+/** Runs dropped by cancellation or collapsed into another run. */
+@property (nonatomic, readonly) NSUInteger coalescedCount;
+
+@end
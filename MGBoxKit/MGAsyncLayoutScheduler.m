@@ -0,0 +1,215 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGAsyncLayoutScheduler.h"
+#import "MGLayoutBox.h"
+
+@interface MGAsyncLayoutJob : NSObject
+
+@property (nonatomic, weak) UIView <MGLayoutBox> *box;
+@property (atomic, assign) NSUInteger generation;
+@property (nonatomic, assign) BOOL pending, running, rerun, suspended;
+
+@end
+
+@implementation MGAsyncLayoutJob
+@end
+
+@implementation MGAsyncLayoutScheduler {
+    NSMapTable *_jobs;
+    NSMutableArray *_pending;
+    BOOL _startQueued;
+}
+
++ (instancetype)sharedScheduler {
+    static MGAsyncLayoutScheduler *scheduler;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        scheduler = self.new;
+    });
+    return scheduler;
+}
+
+- (id)init {
+    self = [super init];
+    _jobs = NSMapTable.weakToStrongObjectsMapTable;
+    _pending = @[].mutableCopy;
+    self.maxConcurrent = MAX(NSProcessInfo.processInfo.activeProcessorCount, 2);
+    return self;
+}
+
+#pragma mark - Scheduling
+
+- (void)scheduleLayoutFor:(UIView <MGLayoutBox> *)box {
+    NSAssert(NSThread.isMainThread, @"Async layouts must be scheduled on the main thread");
+    if (!box.asyncLayout && !box.asyncLayoutOnce) {
+        return;
+    }
+
+    MGAsyncLayoutJob *job = [_jobs objectForKey:box];
+    if (!job) {
+        job = MGAsyncLayoutJob.new;
+        job.box = box;
+        [_jobs setObject:job forKey:box];
+    }
+    job.generation++;
+
+    if (job.running) {
+        if (job.rerun) {
+            _coalescedCount++;
+        }
+        job.rerun = YES;
+        return;
+    }
+    if (job.pending) {
+        _coalescedCount++;
+        return;
+    }
+    job.pending = YES;
+    if (!job.suspended) {
+        [_pending addObject:job];
+        [self setNeedsStart];
+    }
+}
+
+- (void)cancelLayoutFor:(UIView <MGLayoutBox> *)box {
+    MGAsyncLayoutJob *job = [_jobs objectForKey:box];
+    if (!job) {
+        return;
+    }
+    job.generation++;
+    if (job.pending || job.rerun) {
+        _coalescedCount++;
+    }
+    job.pending = NO;
+    job.rerun = NO;
+    [_pending removeObjectIdenticalTo:job];
+}
+
+- (void)suspendLayoutFor:(UIView <MGLayoutBox> *)box {
+    MGAsyncLayoutJob *job = [_jobs objectForKey:box];
+    if (!job || job.suspended) {
+        return;
+    }
+    job.suspended = YES;
+    [_pending removeObjectIdenticalTo:job];
+}
+
+- (void)resumeLayoutFor:(UIView <MGLayoutBox> *)box {
+    MGAsyncLayoutJob *job = [_jobs objectForKey:box];
+    if (!job.suspended) {
+        return;
+    }
+    job.suspended = NO;
+    if (job.pending) {
+        [_pending addObject:job];
+        [self setNeedsStart];
+    }
+}
+
+#pragma mark - Running
+
+// wait for the end of the current run loop pass, so that a whole layout's
+// worth of boxes can be prioritised together
+- (void)setNeedsStart {
+    if (_startQueued) {
+        return;
+    }
+    _startQueued = YES;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        self->_startQueued = NO;
+        [self prioritiseJobs];
+        [self startJobs];
+    });
+}
+
+// on screen boxes first, otherwise in the order they were scheduled. sorted
+// once per pass instead of per job started, since a scroll can queue hundreds
+- (void)prioritiseJobs {
+    NSMutableArray *onScreen = @[].mutableCopy, *offScreen = @[].mutableCopy;
+    for (MGAsyncLayoutJob *job in _pending) {
+        UIView *box = job.box;
+        if (box) {
+            [[self boxIsOnScreen:box] ? onScreen : offScreen addObject:job];
+        }
+    }
+    [onScreen addObjectsFromArray:offScreen];
+    _pending = onScreen;
+}
+
+- (void)startJobs {
+    while (_runningCount < self.maxConcurrent && _pending.count) {
+        MGAsyncLayoutJob *job = _pending.firstObject;
+        [_pending removeObjectAtIndex:0];
+        if (job.box) {
+            [self run:job];
+        }
+    }
+}
+
+- (BOOL)boxIsOnScreen:(UIView *)box {
+    UIWindow *window = box.window;
+    if (!window || box.hidden) {
+        return NO;
+    }
+    return CGRectIntersectsRect([box convertRect:box.bounds toView:nil], window.bounds);
+}
+
+- (void)run:(MGAsyncLayoutJob *)job {
+    UIView <MGLayoutBox> *box = job.box;
+    MGBlock layout = box.asyncLayout, once = box.asyncLayoutOnce;
+    box.asyncLayoutOnce = nil;
+    job.pending = NO;
+    if (!layout && !once) {
+        return;
+    }
+
+    job.running = YES;
+    _runningCount++;
+    NSUInteger generation = job.generation;
+    dispatch_async(box.asyncQueue, ^{
+
+        // skip if cancelled or superseded while waiting in the box's queue
+        BOOL current = job.generation == generation;
+        if (current) {
+            if (layout) {
+                layout();
+            }
+            if (once) {
+                once();
+            }
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+
+            // a skipped once block still gets its one run
+            UIView <MGLayoutBox> *box = job.box;
+            if (!current && once && !box.asyncLayoutOnce) {
+                box.asyncLayoutOnce = once;
+            }
+            [self finish:job];
+        });
+    });
+}
+
+- (void)finish:(MGAsyncLayoutJob *)job {
+    job.running = NO;
+    _runningCount--;
+    if (job.rerun && job.box) {
+        job.rerun = NO;
+        job.pending = YES;
+        if (!job.suspended) {
+            [_pending addObject:job];
+            [self setNeedsStart];
+        }
+    }
+    [self startJobs];
+}
+
+#pragma mark - Getters
+
+- (NSUInteger)pendingCount {
+    return _pending.count;
+}
+
+@end
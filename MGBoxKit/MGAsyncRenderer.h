@@ -0,0 +1,111 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+#import "MGMemoryBudget.h"
+
+/**
+* A snapshot of a single static subview (a label's text, an image view's image,
+* or a plain coloured view), taken on the main thread for drawing on a
+* background queue.
+*/
+@interface MGAsyncDisplayItem : NSObject
+
+@property (nonatomic, assign) CGRect frame;
+@property (nonatomic, strong) UIColor *fillColor;
+@property (nonatomic, strong) UIImage *image;
+@property (nonatomic, strong) NSAttributedString *text;
+@property (nonatomic, assign) NSInteger numberOfLines;
+@property (nonatomic, strong) UIColor *shadowColor;
+@property (nonatomic, assign) CGSize shadowOffset;
+
+/**
+* Returns an item for the given view, or `nil` if the view's content can't be
+* drawn off the main thread (eg controls, scroll views, views with subviews).
+*/
++ (instancetype)itemForView:(UIView *)view;
+
+@end
+
+/**
+* Cancellation token for a single render. Cancelling is thread safe.
+*/
+@interface MGAsyncRenderToken : NSObject
+
+@property (atomic, assign, getter=isCancelled) BOOL cancelled;
+
+@end
+
+/**
+* Identifies a cached bitmap by a box's data key and size. Keys are equal only
+* when their data keys are equal, so `@1` and `@"1"` don't share a bitmap.
+*/
+@interface MGAsyncRenderCacheKey : NSObject
+
+@property (nonatomic, readonly) id dataKey;
+@property (nonatomic, readonly) CGSize size;
+
+@end
+
+/**
+* Draws <MGAsyncDisplayItem> lists into bitmaps on a background queue, and keeps
+* the results in a cache. Used by [asyncDisplay](-[MGBox asyncDisplay]).
+*
+* The image cache and snapshot contexts are registered with the
+* <MGMemoryBudget>.
+*/
+
+@interface MGAsyncRenderer : NSObject <MGTrimmableCache>
+
++ (instancetype)sharedRenderer;
+
+/**
+* The cache key for a box's bitmap, made from its data key and size. Returns
+* `nil` if there is no data key.
+*/
++ (MGAsyncRenderCacheKey *)cacheKeyForDataKey:(id)dataKey size:(CGSize)size;
+
+- (UIImage *)cachedImageForKey:(MGAsyncRenderCacheKey *)key;
+
+/**
+* Draws the items on a background queue, then calls `completion` on the main
+* queue, unless the token was cancelled in the meantime. A non-nil `cacheKey`
+* caches the result.
+*/
+- (void)renderItems:(NSArray *)items size:(CGSize)size
+      cacheKey:(MGAsyncRenderCacheKey *)cacheKey
+      token:(MGAsyncRenderToken *)token completion:(void (^)(UIImage *image))completion;
+
+#pragma mark - Snapshots
+
+/**
+* Renders the box's layer into a bitmap at screen scale, clipped to its corner
+* radius. Bitmap contexts are kept and reused for boxes of the same size. Must
+* be called on the main thread.
+*/
+- (UIImage *)snapshotOfView:(UIView *)view;
+
+/**
+* Composites a snapshot onto a transparent canvas with a 20pt margin, a drop
+* shadow drawn from the snapshot's rounded rect path, and a light border. Safe
+* to call on any thread.
+*/
++ (UIImage *)shadowedSnapshot:(UIImage *)snapshot cornerRadius:(CGFloat)radius
+      scale:(CGFloat)scale;
+
+/**
+* Snapshots each view on the main thread, then composites the shadows on a
+* background queue. The completion block is called on the main queue, with
+* images in the same order as the views (`NSNull` for zero sized views).
+*/
+- (void)snapshotViews:(NSArray *)views withShadow:(BOOL)shadow scale:(CGFloat)scale
+      completion:(void (^)(NSArray *images))completion;
+
+/**
+* Empties the image cache. Call this when the content for existing data keys
+* has changed.
+*/
+- (void)removeAllCachedImages;
+
+@end
@@ -0,0 +1,413 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGAsyncRenderer.h"
+
+@implementation MGAsyncDisplayItem
+
++ (instancetype)itemForView:(UIView *)view {
+  if (view.hidden || view.alpha < 1 || view.subviews.count
+        || !CGAffineTransformIsIdentity(view.transform) || view.layer.cornerRadius
+        || view.layer.sublayers.count || view.layer.shadowOpacity) {
+    return nil;
+  }
+
+  MGAsyncDisplayItem *item;
+  if ([view isKindOfClass:UILabel.class]) {
+    UILabel *label = (id)view;
+    if (!label.attributedText.length && !label.backgroundColor) {
+      return nil;
+    }
+    item = self.new;
+    item.text = label.attributedText;
+    item.numberOfLines = label.numberOfLines;
+    item.shadowColor = label.shadowColor;
+    item.shadowOffset = label.shadowOffset;
+
+  } else if ([view isKindOfClass:UIImageView.class]) {
+    UIImageView *imageView = (id)view;
+    if (imageView.isAnimating || imageView.animationImages
+          || imageView.contentMode != UIViewContentModeScaleToFill) {
+      return nil;
+    }
+    item = self.new;
+    item.image = imageView.image;
+
+  } else if ([view isMemberOfClass:UIView.class]) {
+    if (!view.backgroundColor) {
+      return nil;
+    }
+    item = self.new;
+
+  } else {
+    return nil;
+  }
+
+  item.frame = view.frame;
+  item.fillColor = view.backgroundColor;
+  return item;
+}
+
+- (void)drawInContext:(CGContextRef)context {
+  if (self.fillColor) {
+    CGContextSetFillColorWithColor(context, self.fillColor.CGColor);
+    CGContextFillRect(context, self.frame);
+  }
+  if (self.image) {
+    [self.image drawInRect:self.frame];
+  }
+  if (self.text.length) {
+    [self drawTextInContext:context];
+  }
+}
+
+- (void)drawTextInContext:(CGContextRef)context {
+  NSStringDrawingOptions options = NSStringDrawingUsesLineFragmentOrigin
+        | NSStringDrawingUsesFontLeading | NSStringDrawingTruncatesLastVisibleLine;
+
+  // labels centre their text vertically. a single line is measured unbounded,
+  // as MGLine does, then drawn one line high so its tail is truncated
+  CGSize size = self.frame.size;
+  if (self.numberOfLines == 1) {
+    size = (CGSize){CGFLOAT_MAX, CGFLOAT_MAX};
+  }
+  CGRect textRect = [self.text boundingRectWithSize:size options:options context:nil];
+  CGFloat height = MIN(ceil(textRect.size.height), self.frame.size.height);
+  CGRect rect = self.frame;
+  rect.origin.y += floor((rect.size.height - height) / 2);
+  rect.size.height = height;
+
+  CGContextSaveGState(context);
+  if (self.shadowColor) {
+    CGContextSetShadowWithColor(context, self.shadowOffset, 0, self.shadowColor.CGColor);
+  }
+  [self.text drawWithRect:rect options:options context:nil];
+  CGContextRestoreGState(context);
+}
+
+@end
+
+@implementation MGAsyncRenderToken
+@end
+
+@interface MGAsyncRenderCacheKey ()
++ (instancetype)keyWithDataKey:(id)dataKey size:(CGSize)size;
+@end
+
+@implementation MGAsyncRenderCacheKey
+
++ (instancetype)keyWithDataKey:(id)dataKey size:(CGSize)size {
+  MGAsyncRenderCacheKey *key = self.new;
+  key->_dataKey = dataKey;
+  key->_size = size;
+  return key;
+}
+
+- (BOOL)isEqual:(MGAsyncRenderCacheKey *)other {
+  if (other == self) {
+    return YES;
+  }
+  return [other isKindOfClass:MGAsyncRenderCacheKey.class]
+        && CGSizeEqualToSize(_size, other->_size) && [_dataKey isEqual:other->_dataKey];
+}
+
+- (NSUInteger)hash {
+  return [_dataKey hash] ^ ((NSUInteger)(_size.width * 31) << 16) ^ (NSUInteger)_size.height;
+}
+
+@end
+
+@interface MGAsyncRenderer () <NSCacheDelegate>
+@end
+
+static NSUInteger MGCostOfImage(UIImage *image) {
+  CGImageRef cgImage = image.CGImage;
+  return cgImage ? CGImageGetBytesPerRow(cgImage) * CGImageGetHeight(cgImage) : 0;
+}
+
+@implementation MGAsyncRenderer {
+  dispatch_queue_t _queue;
+  NSCache *_images;
+  NSUInteger _imagesCost, _contextsCost;
+  NSMutableDictionary *_snapshotContexts;
+}
+
++ (instancetype)sharedRenderer {
+  static MGAsyncRenderer *renderer;
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    renderer = self.new;
+  });
+  return renderer;
+}
+
+- (id)init {
+  self = [super init];
+  _queue = dispatch_queue_create("MGAsyncRenderer", DISPATCH_QUEUE_CONCURRENT);
+  _images = NSCache.new;
+  _images.countLimit = 200;
+  _images.delegate = self;
+  _snapshotContexts = @{}.mutableCopy;
+  [MGMemoryBudget.sharedBudget registerCache:self];
+  return self;
+}
+
++ (MGAsyncRenderCacheKey *)cacheKeyForDataKey:(id)dataKey size:(CGSize)size {
+  if (!dataKey) {
+    return nil;
+  }
+  return [MGAsyncRenderCacheKey keyWithDataKey:dataKey size:size];
+}
+
+- (UIImage *)cachedImageForKey:(MGAsyncRenderCacheKey *)key {
+  return key ? [_images objectForKey:key] : nil;
+}
+
+- (void)cacheImage:(UIImage *)image forKey:(MGAsyncRenderCacheKey *)key {
+  NSUInteger cost = MGCostOfImage(image);
+
+  // replacing an image doesn't reliably go through the delegate, so remove the
+  // old one first to take its cost off the total
+  [_images removeObjectForKey:key];
+  @synchronized (self) {
+    _imagesCost += cost;
+  }
+  [_images setObject:image forKey:key cost:cost];
+  [MGMemoryBudget.sharedBudget cacheDidGrow:self];
+}
+
+- (void)cache:(NSCache *)cache willEvictObject:(id)image {
+  NSUInteger cost = MGCostOfImage(image);
+  @synchronized (self) {
+    _imagesCost -= MIN(_imagesCost, cost);
+  }
+}
+
+- (void)renderItems:(NSArray *)items size:(CGSize)size
+      cacheKey:(MGAsyncRenderCacheKey *)cacheKey
+      token:(MGAsyncRenderToken *)token completion:(void (^)(UIImage *image))completion {
+  if (size.width <= 0 || size.height <= 0) {
+    return;
+  }
+  CGFloat scale = UIScreen.mainScreen.scale;
+
+  dispatch_async(_queue, ^{
+    if (token.cancelled) {
+      return;
+    }
+
+    UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+    for (MGAsyncDisplayItem *item in items) {
+      if (token.cancelled) {
+        break;
+      }
+      [item drawInContext:context];
+    }
+    UIImage *image = token.cancelled ? nil : UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    if (!image) {
+      return;
+    }
+    if (cacheKey) {
+      [self cacheImage:image forKey:cacheKey];
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+      if (!token.cancelled && completion) {
+        completion(image);
+      }
+    });
+  });
+}
+
+#pragma mark - Snapshots
+
+static CGContextRef MGCreateBitmapContext(size_t width, size_t height) {
+  CGColorSpaceRef space = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, space,
+        kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Host);
+  CGColorSpaceRelease(space);
+  return context;
+}
+
+- (UIImage *)snapshotOfView:(UIView *)view {
+  NSAssert(NSThread.isMainThread, @"Views can only be snapshotted on the main thread");
+  CGSize size = view.bounds.size;
+  CGFloat scale = UIScreen.mainScreen.scale;
+  size_t width = (size_t)ceil(size.width * scale), height = (size_t)ceil(size.height * scale);
+  if (!width || !height) {
+    return nil;
+  }
+
+  // same sized boxes (eg table rows) share a context
+  NSValue *key = [NSValue valueWithCGSize:CGSizeMake(width, height)];
+  id context = _snapshotContexts[key];
+  if (!context) {
+    CGContextRef newContext = MGCreateBitmapContext(width, height);
+    if (!newContext) {
+      return nil;
+    }
+    context = (__bridge_transfer id)newContext;
+    if (_snapshotContexts.count >= 4) {
+      [_snapshotContexts removeAllObjects];
+      _contextsCost = 0;
+    }
+    _snapshotContexts[key] = context;
+    _contextsCost += CGBitmapContextGetBytesPerRow(newContext) * height;
+    [MGMemoryBudget.sharedBudget cacheDidGrow:self];
+  }
+  CGContextRef ctx = (__bridge CGContextRef)context;
+
+  CGContextClearRect(ctx, CGRectMake(0, 0, width, height));
+  CGContextSaveGState(ctx);
+
+  // flip to UIKit coordinates
+  CGContextTranslateCTM(ctx, 0, height);
+  CGContextScaleCTM(ctx, scale, -scale);
+
+  CGFloat radius = MIN(view.layer.cornerRadius, MIN(size.width, size.height) / 2);
+  if (radius > 0) {
+    CGPathRef clip = CGPathCreateWithRoundedRect(view.bounds, radius, radius, NULL);
+    CGContextAddPath(ctx, clip);
+    CGContextClip(ctx);
+    CGPathRelease(clip);
+  }
+  [view.layer renderInContext:ctx];
+  CGContextRestoreGState(ctx);
+
+  CGImageRef cgImage = CGBitmapContextCreateImage(ctx);
+  UIImage *image = [UIImage imageWithCGImage:cgImage scale:scale
+        orientation:UIImageOrientationUp];
+  CGImageRelease(cgImage);
+  return image;
+}
+
++ (UIImage *)shadowedSnapshot:(UIImage *)snapshot cornerRadius:(CGFloat)radius
+      scale:(CGFloat)scale {
+  if (!snapshot.CGImage) {
+    return nil;
+  }
+  if (scale <= 0) {
+    scale = snapshot.scale;
+  }
+  CGFloat pad = 20;
+  CGSize size = snapshot.size;
+  size_t width = (size_t)ceil((size.width + pad * 2) * scale);
+  size_t height = (size_t)ceil((size.height + pad * 2) * scale);
+  CGContextRef ctx = MGCreateBitmapContext(width, height);
+  if (!ctx) {
+    return nil;
+  }
+  CGContextScaleCTM(ctx, scale, scale);
+
+  // the canvas is symmetric, so no need to flip
+  CGRect rect = CGRectMake(pad, pad, size.width, size.height);
+  radius = MIN(radius, MIN(size.width, size.height) / 2);
+  CGPathRef path = CGPathCreateWithRoundedRect(rect, radius, radius, NULL);
+
+  // shadow from the path instead of blurring the image's alpha. clipped to
+  // outside the path, so the fill itself never shows
+  CGContextSaveGState(ctx);
+  CGContextAddRect(ctx, CGRectInset(rect, -pad, -pad));
+  CGContextAddPath(ctx, path);
+  CGContextEOClip(ctx);
+  UIColor *shadowColor = [UIColor colorWithWhite:0 alpha:0.2];
+  CGContextSetShadowWithColor(ctx, CGSizeZero, 20, shadowColor.CGColor);
+  CGContextSetFillColorWithColor(ctx, UIColor.blackColor.CGColor);
+  CGContextAddPath(ctx, path);
+  CGContextFillPath(ctx);
+  CGContextRestoreGState(ctx);
+
+  // the snapshot
+  CGContextSaveGState(ctx);
+  CGContextAddPath(ctx, path);
+  CGContextClip(ctx);
+  CGContextDrawImage(ctx, rect, snapshot.CGImage);
+  CGContextRestoreGState(ctx);
+
+  // the border, inside the edge like a layer border
+  CGRect inset = CGRectInset(rect, 0.5, 0.5);
+  CGFloat insetRadius = MAX(radius - 0.5, 0);
+  CGPathRef border = CGPathCreateWithRoundedRect(inset, insetRadius, insetRadius, NULL);
+  UIColor *borderColor = [UIColor colorWithWhite:0.65 alpha:0.7];
+  CGContextSetStrokeColorWithColor(ctx, borderColor.CGColor);
+  CGContextSetLineWidth(ctx, 1);
+  CGContextAddPath(ctx, border);
+  CGContextStrokePath(ctx);
+  CGPathRelease(border);
+  CGPathRelease(path);
+
+  CGImageRef cgImage = CGBitmapContextCreateImage(ctx);
+  CGContextRelease(ctx);
+  UIImage *image = [UIImage imageWithCGImage:cgImage scale:scale
+        orientation:UIImageOrientationUp];
+  CGImageRelease(cgImage);
+  return image;
+}
+
+- (void)snapshotViews:(NSArray *)views withShadow:(BOOL)shadow scale:(CGFloat)scale
+      completion:(void (^)(NSArray *images))completion {
+  NSMutableArray *snapshots = @[].mutableCopy, *radii = @[].mutableCopy;
+  for (UIView *view in views) {
+    UIImage *snapshot = [self snapshotOfView:view];
+    [snapshots addObject:snapshot ?: NSNull.null];
+    [radii addObject:@(view.layer.cornerRadius)];
+  }
+
+  dispatch_async(_queue, ^{
+    NSMutableArray *images = snapshots;
+    if (shadow) {
+      images = @[].mutableCopy;
+      for (NSUInteger i = 0; i < snapshots.count; i++) {
+        UIImage *image = [snapshots[i] isKindOfClass:UIImage.class]
+              ? [MGAsyncRenderer shadowedSnapshot:snapshots[i]
+                    cornerRadius:[radii[i] floatValue] scale:scale]
+              : nil;
+        [images addObject:image ?: NSNull.null];
+      }
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+      if (completion) {
+        completion(images);
+      }
+    });
+  });
+}
+
+- (void)removeAllCachedImages {
+  [_images removeAllObjects];
+}
+
+#pragma mark - MGTrimmableCache
+
+- (NSString *)cacheName {
+  return @"MGAsyncRenderer";
+}
+
+- (NSUInteger)cacheCost {
+  @synchronized (self) {
+    return _imagesCost + _contextsCost;
+  }
+}
+
+- (void)trimToCost:(NSUInteger)cost {
+
+  // contexts are cheap to recreate, so go first
+  [_snapshotContexts removeAllObjects];
+  _contextsCost = 0;
+
+  if (!cost) {
+    [_images removeAllObjects];
+  } else if (self.cacheCost > cost) {
+
+    // evict down to the cost, then put the usual limit back, so a trim
+    // doesn't cap the cache for good
+    NSUInteger limit = _images.totalCostLimit;
+    _images.totalCostLimit = cost;
+    _images.totalCostLimit = limit;
+  }
+}
+
+@end
@@ -0,0 +1,29 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+/**
+* Draws up to four 1pt edges of different colours in a single layer. The
+* backing bitmap is only a few points square, stretched to the layer's bounds
+* by `contentsCenter`, so resizing never redraws and large boxes don't get
+* large backing stores.
+*
+* Used by <MGBox> for its border colours. Set a colour to `nil` (or a clear
+* colour) to hide that edge.
+*/
+
+@interface MGBorderLayer : CALayer
+
+@property (nonatomic, strong) UIColor *topColor;
+@property (nonatomic, strong) UIColor *bottomColor;
+@property (nonatomic, strong) UIColor *leftColor;
+@property (nonatomic, strong) UIColor *rightColor;
+
+/**
+* Whether any edge has a visible colour.
+*/
+- (BOOL)hasVisibleEdges;
+
+@end
@@ -0,0 +1,81 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBorderLayer.h"
+#import "UIColor+MGExpanded.h"
+
+@implementation MGBorderLayer
+
+- (id)init {
+    self = [super init];
+    self.contentsScale = UIScreen.mainScreen.scale;
+
+    // the middle point stretches, the 1pt edges don't
+    self.contentsCenter = CGRectMake(1.0 / 3, 1.0 / 3, 1.0 / 3, 1.0 / 3);
+
+    // colour changes are immediate, like the old border views
+    self.actions = @{@"contents":NSNull.null};
+    return self;
+}
+
+#pragma mark - Setters
+
+- (void)setTopColor:(UIColor *)color {
+    _topColor = color;
+    [self updateContents];
+}
+
+- (void)setBottomColor:(UIColor *)color {
+    _bottomColor = color;
+    [self updateContents];
+}
+
+- (void)setLeftColor:(UIColor *)color {
+    _leftColor = color;
+    [self updateContents];
+}
+
+- (void)setRightColor:(UIColor *)color {
+    _rightColor = color;
+    [self updateContents];
+}
+
+#pragma mark - Drawing
+
+- (BOOL)hasVisibleEdges {
+    return self.topColor.alpha || self.bottomColor.alpha || self.leftColor.alpha
+          || self.rightColor.alpha;
+}
+
+- (void)updateContents {
+    if (!self.hasVisibleEdges) {
+        self.contents = nil;
+        return;
+    }
+
+    CGFloat scale = self.contentsScale;
+    CGSize size = CGSizeMake(3, 3);
+    UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+
+    // same stacking order as the old border views (last set on the bottom)
+    [self fillRect:CGRectMake(0, 0, 1, 3) color:self.leftColor in:context];
+    [self fillRect:CGRectMake(2, 0, 1, 3) color:self.rightColor in:context];
+    [self fillRect:CGRectMake(0, 2, 3, 1) color:self.bottomColor in:context];
+    [self fillRect:CGRectMake(0, 0, 3, 1) color:self.topColor in:context];
+
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    self.contents = (id)image.CGImage;
+}
+
+- (void)fillRect:(CGRect)rect color:(UIColor *)color in:(CGContextRef)context {
+    if (!color.alpha) {
+        return;
+    }
+    CGContextSetFillColorWithColor(context, color.CGColor);
+    CGContextFillRect(context, rect);
+}
+
+@end
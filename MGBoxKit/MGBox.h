@@ -66,6 +66,43 @@
 */
 @property (nonatomic, assign) BOOL rasterize;
 
+/**
+* If set to YES, the box's static content (labels, image views, and plain
+* coloured views such as borders) is drawn into a single bitmap on a background
+* queue after each layout, and displayed as the layer's contents in place of
+* the individual subviews. Controls, scroll views, and subviews with their own
+* subviews stay live, drawing on top of the bitmap. Defaults to NO.
+*
+* Bitmaps are cached by <asyncDisplayKey> and size, so a box scrolling back on
+* screen with the same data can be displayed without drawing. A pending draw is
+* cancelled if the box is laid out again or reused by a box provider before it
+* finishes.
+*
+* @warning Changes to flattened subviews aren't visible until the next layout.
+*/
+@property (nonatomic, assign) BOOL asyncDisplay;
+
+/**
+* The key the <asyncDisplay> bitmap is cached under. Box providers set this to
+* the box's data key when a [boxKeyMaker]([MGBoxProvider boxKeyMaker]) is set.
+* If `nil`, the bitmap isn't cached.
+*
+* If the content for an existing data key changes, empty the cache with
+* `[MGAsyncRenderer.sharedRenderer removeAllCachedImages]`.
+*/
+@property (nonatomic, copy) id <NSCopying> asyncDisplayKey;
+
+/**
+* Cancels any pending <asyncDisplay> draw and restores the live subviews.
+*/
+- (void)cancelAsyncDisplay;
+
+/**
+* Draws the <asyncDisplay> bitmap. Called at the end of layout, so normally
+* there's no need to call this directly.
+*/
+- (void)updateAsyncDisplay;
+
 /** @name Borders */
 
 /**
@@ -90,25 +127,29 @@
 
 /**
 * The top border view. Modify this directly to achieve deeper border
-* customisation.
+* customisation. Border colours are otherwise drawn by a single layer, and the
+* view is only created when this is accessed.
 */
 @property (nonatomic, retain) UIView *topBorder;
 
 /**
 * The bottom border view. Modify this directly to achieve deeper border
-* customisation.
+* customisation. Border colours are otherwise drawn by a single layer, and the
+* view is only created when this is accessed.
 */
 @property (nonatomic, retain) UIView *bottomBorder;
 
 /**
 * The left border view. Modify this directly to achieve deeper border
-* customisation.
+* customisation. Border colours are otherwise drawn by a single layer, and the
+* view is only created when this is accessed.
 */
 @property (nonatomic, retain) UIView *leftBorder;
 
 /**
 * The right border view. Modify this directly to achieve deeper border
-* customisation.
+* customisation. Border colours are otherwise drawn by a single layer, and the
+* view is only created when this is accessed.
 */
 @property (nonatomic, retain) UIView *rightBorder;
 
@@ -159,6 +200,16 @@ colours (in that order).
 */
 - (UIImage *)screenshotWithShadow:(BOOL)shadow scale:(float)scale;
 
+/**
+* Screenshots a batch of boxes, eg for drag reordering or share previews. Each
+* box's layer is rendered once on the main thread, with the shadows composited
+* on a background queue. The completion block is called on the main queue,
+* with screenshots in the same order as the boxes (`NSNull` for zero sized
+* boxes).
+*/
++ (void)screenshotsOfBoxes:(NSArray *)boxes withShadow:(BOOL)shadow scale:(float)scale
+      completion:(void (^)(NSArray *screenshots))completion;
+
 /** @name Tapping */
 
 /**
@@ -179,4 +230,19 @@ colours (in that order).
  */
 @property (nonatomic, copy) void (^onHighlightChanged)(BOOL highlighted);
 
+/**
+ * YES if the box's superview is an <MGScrollView> with
+ * [dispatchesBoxGestures](-[MGScrollView dispatchesBoxGestures]) enabled, in
+ * which case the box's own tap, swipe, and long press recognisers aren't
+ * attached.
+ */
+@property (nonatomic, readonly) BOOL gesturesHandledByContainer;
+
+/**
+ * Attaches or detaches the box's gesture recognisers to match its tappable,
+ * swipable, and long pressable state. Called automatically when those change
+ * or the box moves to a new superview.
+ */
+- (void)updateGestureRecognizers;
+
 @end
@@ -6,12 +6,18 @@
 
 #import "MGBox.h"
 #import "MGLayoutManager.h"
+#import "MGAsyncLayoutScheduler.h"
+#import "MGScrollView.h"
 #import "UIColor+MGExpanded.h"
+#import "MGAsyncRenderer.h"
+#import "MGBorderLayer.h"
 
 @implementation MGBox {
   BOOL fixedPositionEstablished;
-  BOOL asyncDrawing, asyncDrawOnceing;
   BOOL watchingHighlightChanged;
+  MGAsyncRenderToken *asyncDisplayToken;
+  NSArray *asyncDisplayHiddenViews;
+  MGBorderLayer *borderLayer;
 }
 
 // MGLayoutBox protocol
@@ -71,42 +77,18 @@
   [MGLayoutManager layoutBoxesIn:self];
 
   // async draws
-  if (self.asyncLayout || self.asyncLayoutOnce) {
-    dispatch_async(self.asyncQueue, ^{
-        if (self.asyncLayout && !self->asyncDrawing) {
-            self->asyncDrawing = YES;
-            self.asyncLayout();
-            self->asyncDrawing = NO;
-        }
-        if (self.asyncLayoutOnce && !self->asyncDrawOnceing) {
-            self->asyncDrawOnceing = YES;
-            self.asyncLayoutOnce();
-            self.asyncLayoutOnce = nil;
-            self->asyncDrawOnceing = NO;
-        }
-    });
-  }
+  [MGAsyncLayoutScheduler.sharedScheduler scheduleLayoutFor:self];
+
+  [self updateAsyncDisplay];
 }
 
 - (void)layoutWithDuration:(NSTimeInterval)duration completion:(MGBlock)completion {
     [MGLayoutManager layoutBoxesIn:self duration:duration completion:completion];
 
     // async draws
-    if (self.asyncLayout || self.asyncLayoutOnce) {
-        dispatch_async(self.asyncQueue, ^{
-            if (self.asyncLayout && !self->asyncDrawing) {
-                self->asyncDrawing = YES;
-                self.asyncLayout();
-                self->asyncDrawing = NO;
-            }
-            if (self.asyncLayoutOnce && !self->asyncDrawOnceing) {
-                self->asyncDrawOnceing = YES;
-                self.asyncLayoutOnce();
-                self.asyncLayoutOnce = nil;
-                self->asyncDrawOnceing = NO;
-            }
-        });
-    }
+    [MGAsyncLayoutScheduler.sharedScheduler scheduleLayoutFor:self];
+
+    [self updateAsyncDisplay];
 }
 
 - (void)appeared {
@@ -133,49 +115,167 @@
     }
 }
 
+- (void)layoutSubviews {
+  [super layoutSubviews];
+  if (!borderLayer) {
+    return;
+  }
+
+  // follow along if inside an animation block
+  NSTimeInterval duration = UIView.inheritedAnimationDuration;
+  [CATransaction begin];
+  [CATransaction setDisableActions:!duration];
+  [CATransaction setAnimationDuration:duration];
+  borderLayer.frame = self.layer.bounds;
+  [CATransaction commit];
+}
+
+#pragma mark - Async display
+
+- (void)updateAsyncDisplay {
+  [self cancelAsyncDisplay];
+  if (!self.asyncDisplay) {
+    return;
+  }
+
+  // snapshot the static subviews
+  NSMutableArray *items = @[].mutableCopy, *views = @[].mutableCopy;
+  for (UIView *view in self.subviews) {
+    MGAsyncDisplayItem *item = [MGAsyncDisplayItem itemForView:view];
+    if (item) {
+      [items addObject:item];
+      [views addObject:view];
+    }
+  }
+  if (!items.count) {
+    return;
+  }
+
+  MGAsyncRenderer *renderer = MGAsyncRenderer.sharedRenderer;
+  MGAsyncRenderCacheKey *key = [MGAsyncRenderer cacheKeyForDataKey:self.asyncDisplayKey
+        size:self.size];
+  UIImage *cached = [renderer cachedImageForKey:key];
+  if (cached) {
+    [self showAsyncDisplayImage:cached replacing:views];
+    return;
+  }
+
+  MGAsyncRenderToken *token = MGAsyncRenderToken.new;
+  asyncDisplayToken = token;
+  __weak MGBox *me = self;
+  [renderer renderItems:items size:self.size cacheKey:key token:token
+        completion:^(UIImage *image) {
+      MGBox *box = me;
+      if (box && box->asyncDisplayToken == token) {
+        box->asyncDisplayToken = nil;
+        [box showAsyncDisplayImage:image replacing:views];
+      }
+  }];
+}
+
+- (void)showAsyncDisplayImage:(UIImage *)image replacing:(NSArray *)views {
+  self.layer.contentsScale = image.scale;
+  self.layer.contents = (id)image.CGImage;
+  for (UIView *view in views) {
+    view.hidden = YES;
+  }
+  asyncDisplayHiddenViews = views;
+}
+
+- (void)cancelAsyncDisplay {
+  asyncDisplayToken.cancelled = YES;
+  asyncDisplayToken = nil;
+  if (!asyncDisplayHiddenViews) {
+    return;
+  }
+  self.layer.contents = nil;
+  for (UIView *view in asyncDisplayHiddenViews) {
+    view.hidden = NO;
+  }
+  asyncDisplayHiddenViews = nil;
+}
+
 #pragma mark - Sugar
 
 - (UIImage *)screenshotWithShadow:(BOOL)shadow scale:(float)scale {
-  CGRect frame = CGRectMake(0, 0, self.width + 40, self.height + 40);
+  UIImage *image = [MGAsyncRenderer.sharedRenderer snapshotOfView:self];
+  if (!shadow) {
+    return image;
+  }
+  return [MGAsyncRenderer shadowedSnapshot:image cornerRadius:self.layer.cornerRadius
+        scale:scale];
+}
 
-  // UIImageView of self
-  UIGraphicsBeginImageContextWithOptions(self.size, NO, 0);
-  [[UIBezierPath bezierPathWithRoundedRect:self.bounds
-      cornerRadius:self.layer.cornerRadius] addClip];
-  [self.layer renderInContext:UIGraphicsGetCurrentContext()];
-  UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
-  UIImageView *imageView = [[UIImageView alloc] initWithImage:image];
-  UIGraphicsEndImageContext();
++ (void)screenshotsOfBoxes:(NSArray *)boxes withShadow:(BOOL)shadow scale:(float)scale
+      completion:(void (^)(NSArray *screenshots))completion {
+  [MGAsyncRenderer.sharedRenderer snapshotViews:boxes withShadow:shadow scale:scale
+        completion:completion];
+}
 
-  if (!shadow) {
-      return image;
+#pragma mark - Interaction
+
+- (void)didMoveToWindow {
+  [super didMoveToWindow];
+  if (self.window && !self.hidden) {
+    [MGAsyncLayoutScheduler.sharedScheduler resumeLayoutFor:self];
+  } else {
+    [MGAsyncLayoutScheduler.sharedScheduler suspendLayoutFor:self];
   }
+}
 
-  // setup the shadow
-  CGFloat cx = roundf(frame.size.width / 2), cy = roundf(frame.size.height / 2);
-  cy = (int)self.height % 2 ? cy + 0.5 : cy; // avoid blur
-  imageView.center = CGPointMake(cx, cy);
-  imageView.layer.backgroundColor = UIColor.clearColor.CGColor;
-  imageView.layer.borderColor = [UIColor colorWithWhite:0.65 alpha:0.7].CGColor;
-  imageView.layer.borderWidth = 1;
-  imageView.layer.cornerRadius = self.layer.cornerRadius;
-  imageView.layer.shadowColor = UIColor.blackColor.CGColor;
-  imageView.layer.shadowOffset = CGSizeZero;
-  imageView.layer.shadowOpacity = 0.2;
-  imageView.layer.shadowRadius = 10;
+- (void)setFrame:(CGRect)frame {
+  super.frame = frame;
+  if ([self.superview isKindOfClass:MGScrollView.class]) {
+    [(MGScrollView *)self.superview subviewFramesDidChange];
+  }
+}
 
-  // final UIImage
-  UIView *canvas = [[UIView alloc] initWithFrame:frame];
-  [canvas addSubview:imageView];
-  UIGraphicsBeginImageContextWithOptions(frame.size, NO, scale);
-  [canvas.layer renderInContext:UIGraphicsGetCurrentContext()];
-  UIImage *final = UIGraphicsGetImageFromCurrentImageContext();
-  UIGraphicsEndImageContext();
+- (void)setHidden:(BOOL)hidden {
+  super.hidden = hidden;
+  if ([self.superview isKindOfClass:MGScrollView.class]) {
+    [(MGScrollView *)self.superview subviewFramesDidChange];
+  }
+  if (hidden) {
+    [MGAsyncLayoutScheduler.sharedScheduler suspendLayoutFor:self];
+  } else if (self.window) {
+    [MGAsyncLayoutScheduler.sharedScheduler resumeLayoutFor:self];
+  }
+}
 
-  return final;
+- (void)didMoveToSuperview {
+  [super didMoveToSuperview];
+  if (tappable || swipable || longPressable) {
+    [self updateGestureRecognizers];
+  }
 }
 
-#pragma mark - Interaction
+- (void)updateGestureRecognizers {
+
+  // the container's shared recognisers stand in for ours
+  BOOL own = !self.gesturesHandledByContainer;
+
+  if (tappable && own) {
+    [self addGestureRecognizer:self.tapper];
+  } else if (tapper) {
+    [self removeGestureRecognizer:tapper];
+  }
+  if (swipable && own) {
+    [self addGestureRecognizer:self.swiper];
+  } else if (swiper) {
+    [self removeGestureRecognizer:swiper];
+  }
+  if (longPressable && own) {
+    [self addGestureRecognizer:self.longPresser];
+  } else if (longPresser) {
+    [self removeGestureRecognizer:longPresser];
+  }
+
+  if (tappable || longPressable) {
+    self.exclusiveTouch = !self.allowSimultaneousTaps;
+  } else {
+    self.exclusiveTouch = NO;
+  }
+}
 
 - (void)tapped {
   if (self.onTap) {
@@ -231,6 +331,13 @@
   }
 }
 
+- (void)setAsyncDisplay:(BOOL)async {
+  _asyncDisplay = async;
+  if (!async) {
+    [self cancelAsyncDisplay];
+  }
+}
+
 - (void)setMargin:(UIEdgeInsets)_margin {
   self.topMargin = _margin.top;
   self.rightMargin = _margin.right;
@@ -261,13 +368,7 @@
     return;
   }
   tappable = can;
-  if (can) {
-    [self addGestureRecognizer:self.tapper];
-    self.exclusiveTouch = !self.allowSimultaneousTaps;
-  } else if (self.tapper) {
-    [self removeGestureRecognizer:self.tapper];
-    self.exclusiveTouch = !self.allowSimultaneousTaps && !self.longPressable;
-  }
+  [self updateGestureRecognizers];
 }
 
 - (void)setSwipable:(BOOL)can {
@@ -275,11 +376,7 @@
     return;
   }
   swipable = can;
-  if (can) {
-    [self addGestureRecognizer:self.swiper];
-  } else if (self.swiper) {
-    [self removeGestureRecognizer:self.swiper];
-  }
+  [self updateGestureRecognizers];
 }
 
 - (void)setLongPressable:(BOOL)can {
@@ -287,13 +384,7 @@
     return;
   }
   longPressable = can;
-  if (can) {
-    [self addGestureRecognizer:self.longPresser];
-    self.exclusiveTouch = !self.allowSimultaneousTaps;
-  } else if (self.longPresser) {
-    [self removeGestureRecognizer:self.longPresser];
-    self.exclusiveTouch = !self.allowSimultaneousTaps && !self.tappable;
-  }
+  [self updateGestureRecognizers];
 }
 
 - (void)setOnTap:(MGBlock)_onTap {
@@ -347,6 +438,16 @@
   [MGBox optimizeView:self forColor:color];
 }
 
+- (void)updateBorderView:(UIView *)border color:(UIColor *)color {
+  if (color.alpha) {
+    border.backgroundColor = color;
+    [MGBox optimizeView:border forColor:color];
+    [self insertSubview:border atIndex:0];
+  } else {
+    [border removeFromSuperview];
+  }
+}
+
 - (void)setBorderColors:(id)colors {
   if ([colors isKindOfClass:UIColor.class]) {
     self.topBorderColor = colors;
@@ -363,54 +464,59 @@
 
 - (void)setTopBorderColor:(UIColor *)color {
   _topBorderColor = color;
-  if (color.alpha) {
-    self.topBorder.backgroundColor = color;
-    [MGBox optimizeView:self.topBorder forColor:color];
-    [self insertSubview:self.topBorder atIndex:0];
+  if (_topBorder) {
+    [self updateBorderView:_topBorder color:color];
+    if (!color.alpha) {
+      self.topBorder = nil;
+    }
   } else {
-    [self.topBorder removeFromSuperview];
-    self.topBorder = nil;
+    self.borderLayer.topColor = color;
   }
 }
 
 - (void)setBottomBorderColor:(UIColor *)color {
   _bottomBorderColor = color;
-  if (color.alpha) {
-    self.bottomBorder.backgroundColor = color;
-    [MGBox optimizeView:self.bottomBorder forColor:color];
-    [self insertSubview:self.bottomBorder atIndex:0];
+  if (_bottomBorder) {
+    [self updateBorderView:_bottomBorder color:color];
+    if (!color.alpha) {
+      self.bottomBorder = nil;
+    }
   } else {
-    [self.bottomBorder removeFromSuperview];
-    self.bottomBorder = nil;
+    self.borderLayer.bottomColor = color;
   }
 }
 
 - (void)setLeftBorderColor:(UIColor *)color {
   _leftBorderColor = color;
-  if (color.alpha) {
-    self.leftBorder.backgroundColor = color;
-    [MGBox optimizeView:self.leftBorder forColor:color];
-    [self insertSubview:self.leftBorder atIndex:0];
+  if (_leftBorder) {
+    [self updateBorderView:_leftBorder color:color];
+    if (!color.alpha) {
+      self.leftBorder = nil;
+    }
   } else {
-    [self.leftBorder removeFromSuperview];
-    self.leftBorder = nil;
+    self.borderLayer.leftColor = color;
   }
 }
 
 - (void)setRightBorderColor:(UIColor *)color {
   _rightBorderColor = color;
-  if (color.alpha) {
-    self.rightBorder.backgroundColor = color;
-    [MGBox optimizeView:self.rightBorder forColor:color];
-    [self insertSubview:self.rightBorder atIndex:0];
+  if (_rightBorder) {
+    [self updateBorderView:_rightBorder color:color];
+    if (!color.alpha) {
+      self.rightBorder = nil;
+    }
   } else {
-    [self.rightBorder removeFromSuperview];
-    self.rightBorder = nil;
+    self.borderLayer.rightColor = color;
   }
 }
 
 #pragma mark - Getters
 
+- (BOOL)gesturesHandledByContainer {
+  id container = self.superview;
+  return [container isKindOfClass:MGScrollView.class] && [container dispatchesBoxGestures];
+}
+
 - (NSMutableArray *)boxes {
   if (!boxes) {
     boxes = @[].mutableCopy;
@@ -466,6 +572,15 @@
 
 #pragma mark - Border getters
 
+- (MGBorderLayer *)borderLayer {
+  if (!borderLayer) {
+    borderLayer = MGBorderLayer.layer;
+    borderLayer.frame = self.layer.bounds;
+    [self.layer insertSublayer:borderLayer atIndex:0];
+  }
+  return borderLayer;
+}
+
 - (UIView *)topBorder {
   if (_topBorder) {
     return _topBorder;
@@ -477,6 +592,10 @@
       | UIViewAutoresizingFlexibleBottomMargin;
   _topBorder.tag = -2;
 
+  // customisable view replaces the border layer edge
+  borderLayer.topColor = nil;
+  [self updateBorderView:_topBorder color:_topBorderColor];
+
   return _topBorder;
 }
 
@@ -491,6 +610,10 @@
       | UIViewAutoresizingFlexibleTopMargin;
   _bottomBorder.tag = -2;
 
+  // customisable view replaces the border layer edge
+  borderLayer.bottomColor = nil;
+  [self updateBorderView:_bottomBorder color:_bottomBorderColor];
+
   return _bottomBorder;
 }
 
@@ -505,6 +628,10 @@
       | UIViewAutoresizingFlexibleRightMargin;
   _leftBorder.tag = -2;
 
+  // customisable view replaces the border layer edge
+  borderLayer.leftColor = nil;
+  [self updateBorderView:_leftBorder color:_leftBorderColor];
+
   return _leftBorder;
 }
 
@@ -519,6 +646,10 @@
       | UIViewAutoresizingFlexibleLeftMargin;
   _rightBorder.tag = -2;
 
+  // customisable view replaces the border layer edge
+  borderLayer.rightColor = nil;
+  [self updateBorderView:_rightBorder color:_rightBorderColor];
+
   return _rightBorder;
 }
 
@@ -0,0 +1,146 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+/**
+* Flat storage for the frames computed by <MGLayoutManager> for a box provider,
+* along with the running bounds needed to find the frames intersecting a rect
+* by binary search instead of walking every frame.
+*
+* The index also holds the stacking state (current row position, and column
+* heights for masonry layouts), so that frames can be appended to incrementally
+* without restacking the frames before them.
+*/
+
+@interface MGBoxFrameIndex : NSObject
+
++ (instancetype)frameIndexWithCapacity:(NSUInteger)capacity;
+
+/**
+* Returns an index for a grid of identically sized and spaced boxes. Frames,
+* extent, and lookups are computed arithmetically from the index, so no
+* per-box storage is needed. Frames can't be added to a uniform index.
+*/
++ (instancetype)uniformFrameIndexWithCount:(NSUInteger)count origin:(CGPoint)origin
+      boxSize:(CGSize)size margin:(UIEdgeInsets)margin columns:(NSUInteger)columns;
+
+/**
+* Returns an index for a grid of rows and columns of varying heights and widths,
+* eg a spreadsheet. `rowEdges` and `columnEdges` hold `CGFloat` offsets from
+* `origin` of each row's top and each column's left edge, plus a final bottom or
+* right edge, so start with zero. Each box is its cell inset by `margin`.
+* Frames and lookups binary search the edges, so storage grows with the number
+* of rows plus columns, not the number of boxes. Frames can't be added to a grid
+* index.
+*/
++ (instancetype)gridFrameIndexWithCount:(NSUInteger)count origin:(CGPoint)origin
+      rowEdges:(NSData *)rowEdges columnEdges:(NSData *)columnEdges
+      margin:(UIEdgeInsets)margin;
+
+/**
+* YES for uniform and grid indexes, whose frames are computed instead of stored.
+*/
+@property (nonatomic, readonly) BOOL uniform;
+
+#pragma mark - Storage
+
+/**
+* Returns an index using frame storage previously returned by <storageData>,
+* found at the given offset in `data`. The bytes are used in place (eg from a
+* memory mapped file) until a frame is added, when they're copied.
+*/
++ (instancetype)frameIndexWithStorage:(NSData *)data offset:(NSUInteger)offset
+      count:(NSUInteger)count extent:(CGSize)extent;
+
+/**
+* The number of bytes of storage used by <count> frames.
+*/
++ (NSUInteger)storageLengthForCount:(NSUInteger)count;
+
+/**
+* The frames and their running bounds, packed for writing to disk. Returns
+* `nil` for uniform indexes.
+*/
+@property (nonatomic, readonly) NSData *storageData;
+
+/**
+* YES if the frames are still backed by storage passed to
+* <frameIndexWithStorage:offset:count:extent:>.
+*/
+@property (nonatomic, readonly) BOOL mapped;
+
+#pragma mark - Frames
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)addFrame:(CGRect)frame margin:(UIEdgeInsets)margin;
+- (CGRect)frameAtIndex:(NSUInteger)index;
+
+/**
+* The approximate number of bytes used by the index's storage.
+*/
+@property (nonatomic, readonly) NSUInteger memoryCost;
+
+/**
+* The furthest right and bottom edges of all frames, including their margins.
+*/
+@property (nonatomic, readonly) CGSize extent;
+
+#pragma mark - Lookups
+
+/**
+* Indexes of all frames intersecting the given rect.
+*/
+- (NSIndexSet *)indexesOfFramesIntersectingRect:(CGRect)rect;
+
+/**
+* The index of the last frame containing the given point, or `NSNotFound`.
+*/
+- (NSUInteger)indexOfFrameContainingPoint:(CGPoint)point;
+
+/**
+* The first index that could contain a frame intersecting the horizontal band
+* starting at the given y, ie the first index whose frame or any frame before
+* it extends below `y`. Returns <count> if none do.
+*/
+- (NSUInteger)firstIndexEndingBelowY:(CGFloat)y;
+
+/**
+* The index after the last index that could contain a frame starting above the
+* given y.
+*/
+- (NSUInteger)endIndexStartingAboveY:(CGFloat)y;
+
+#pragma mark - Stacking state
+
+/** The position the next frame will be stacked from. */
+@property (nonatomic, assign) CGPoint cursor;
+
+/** The bottom edge (including margins) of the current grid row. */
+@property (nonatomic, assign) CGFloat rowBottom;
+
+/** The width of each column in a masonry layout. */
+@property (nonatomic, assign) CGFloat columnWidth;
+
+@property (nonatomic, readonly) NSUInteger columnCount;
+
+/**
+* Resets the masonry column heights, with every column starting at `top`.
+*/
+- (void)resetColumns:(NSUInteger)count top:(CGFloat)top;
+
+/**
+* The column with the lowest height, found in `O(1)`. Ties go to the leftmost
+* column.
+*/
+- (NSUInteger)shortestColumn;
+- (CGFloat)heightOfColumn:(NSUInteger)column;
+
+/**
+* Updates the height of the current <shortestColumn>, in `O(log columns)`.
+*/
+- (void)setHeightOfShortestColumn:(CGFloat)height;
+
+@end
@@ -0,0 +1,451 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBoxFrameIndex.h"
+#import "MGLayoutManager.h"
+
+// the range of uniform rows (or columns) overlapping the span from min to max
+static NSRange MGUniformSpan(CGFloat min, CGFloat max, CGFloat start, CGFloat length,
+      CGFloat stride, NSUInteger limit) {
+    if (stride <= 0 || length <= 0 || !limit) {
+        return NSMakeRange(0, 0);
+    }
+    CGFloat first = MAX(floor((min - start - length) / stride) + 1, 0);
+    CGFloat last = MIN(ceil((max - start) / stride) - 1, limit - 1);
+    if (last < first) {
+        return NSMakeRange(0, 0);
+    }
+    return NSMakeRange((NSUInteger)first, (NSUInteger)(last - first) + 1);
+}
+
+// the range of grid rows (or columns) overlapping the span from min to max,
+// with each box inset from its cell's edges by lead and trail
+static NSRange MGEdgeSpan(CGFloat min, CGFloat max, CGFloat start, const CGFloat *edges,
+      NSUInteger count, CGFloat lead, CGFloat trail) {
+
+    // first box ending after min
+    NSUInteger low = 0, high = count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (start + edges[mid + 1] - trail > min) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    NSUInteger first = low;
+
+    // first box from there starting at or after max
+    high = count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (start + edges[mid] + lead >= max) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return NSMakeRange(first, low - first);
+}
+
+@implementation MGBoxFrameIndex {
+    CGRect *_frames;
+
+    // running max of bottom edges, and min of top edges from each index onward.
+    // both are sorted, so can be binary searched whatever the layout style
+    CGFloat *_maxBottoms, *_minTops;
+    NSUInteger _capacity;
+
+    // storage the frames are read from in place, until copied on write
+    NSData *_storage;
+
+    // masonry column heights, and a min heap of column numbers
+    CGFloat *_columnHeights;
+    NSUInteger *_columnHeap;
+
+    // uniform grid metrics
+    CGPoint _origin;
+    CGSize _boxSize, _cellSize;
+    UIEdgeInsets _boxMargin;
+    NSUInteger _columns, _rows;
+
+    // grid row and column edges, when they vary
+    NSData *_rowEdgeData, *_columnEdgeData;
+    const CGFloat *_rowEdges, *_columnEdges;
+}
+
++ (instancetype)frameIndexWithCapacity:(NSUInteger)capacity {
+    MGBoxFrameIndex *index = [[self alloc] init];
+    [index reserveCapacity:MAX(capacity, 1)];
+    return index;
+}
+
++ (instancetype)uniformFrameIndexWithCount:(NSUInteger)count origin:(CGPoint)origin
+      boxSize:(CGSize)size margin:(UIEdgeInsets)margin columns:(NSUInteger)columns {
+    MGBoxFrameIndex *index = [[self alloc] init];
+    [index setUniformCount:count origin:origin boxSize:size margin:margin
+          columns:MAX(columns, 1)];
+    return index;
+}
+
+- (void)setUniformCount:(NSUInteger)count origin:(CGPoint)origin boxSize:(CGSize)size
+      margin:(UIEdgeInsets)margin columns:(NSUInteger)columns {
+    _uniform = YES;
+    _count = count;
+    _origin = origin;
+    _boxSize = size;
+    _boxMargin = margin;
+    _cellSize = (CGSize){
+          margin.left + size.width + margin.right,
+          margin.top + size.height + margin.bottom
+    };
+    _columns = columns;
+    _rows = (count + columns - 1) / columns;
+    if (count) {
+        _extent = (CGSize){
+              origin.x + MIN(count, columns) * _cellSize.width,
+              origin.y + _rows * _cellSize.height
+        };
+    }
+}
+
++ (instancetype)gridFrameIndexWithCount:(NSUInteger)count origin:(CGPoint)origin
+      rowEdges:(NSData *)rowEdges columnEdges:(NSData *)columnEdges
+      margin:(UIEdgeInsets)margin {
+    NSUInteger rows = rowEdges.length / sizeof(CGFloat);
+    NSUInteger columns = columnEdges.length / sizeof(CGFloat);
+    NSAssert(rows && columns && (rows - 1) * (columns - 1) >= count,
+          @"A grid frame index needs an edge after the last row and column");
+
+    MGBoxFrameIndex *index = [[self alloc] init];
+    index->_uniform = YES;
+    index->_count = count;
+    index->_origin = origin;
+    index->_boxMargin = margin;
+    index->_rowEdgeData = rowEdges.copy;
+    index->_columnEdgeData = columnEdges.copy;
+    index->_rowEdges = index->_rowEdgeData.bytes;
+    index->_columnEdges = index->_columnEdgeData.bytes;
+    index->_rows = rows - 1;
+    index->_columns = MAX(columns - 1, 1);
+    if (count) {
+        index->_extent = (CGSize){
+              origin.x + index->_columnEdges[MIN(count, columns - 1)],
+              origin.y + index->_rowEdges[rows - 1]
+        };
+    }
+    return index;
+}
+
++ (instancetype)frameIndexWithStorage:(NSData *)data offset:(NSUInteger)offset
+      count:(NSUInteger)count extent:(CGSize)extent {
+    if (offset + [self storageLengthForCount:count] > data.length) {
+        return nil;
+    }
+    MGBoxFrameIndex *index = [[self alloc] init];
+    const uint8_t *bytes = (const uint8_t *)data.bytes + offset;
+    index->_storage = data;
+    index->_frames = (CGRect *)bytes;
+    index->_maxBottoms = (CGFloat *)(bytes + count * sizeof(CGRect));
+    index->_minTops = index->_maxBottoms + count;
+    index->_count = count;
+    index->_extent = extent;
+    return index;
+}
+
++ (NSUInteger)storageLengthForCount:(NSUInteger)count {
+    return count * (sizeof(CGRect) + sizeof(CGFloat) * 2);
+}
+
+- (NSData *)storageData {
+    if (_uniform) {
+        return nil;
+    }
+    NSMutableData *data = [NSMutableData dataWithCapacity:
+          [MGBoxFrameIndex storageLengthForCount:_count]];
+    [data appendBytes:_frames length:_count * sizeof(CGRect)];
+    [data appendBytes:_maxBottoms length:_count * sizeof(CGFloat)];
+    [data appendBytes:_minTops length:_count * sizeof(CGFloat)];
+    return data;
+}
+
+- (BOOL)mapped {
+    return _storage != nil;
+}
+
+- (void)reserveCapacity:(NSUInteger)capacity {
+    if (_storage) {
+        [self copyStorageWithCapacity:MAX(capacity, _count)];
+        return;
+    }
+    if (capacity <= _capacity) {
+        return;
+    }
+    _frames = realloc(_frames, capacity * sizeof(CGRect));
+    _maxBottoms = realloc(_maxBottoms, capacity * sizeof(CGFloat));
+    _minTops = realloc(_minTops, capacity * sizeof(CGFloat));
+    _capacity = capacity;
+}
+
+- (void)copyStorageWithCapacity:(NSUInteger)capacity {
+    CGRect *frames = malloc(capacity * sizeof(CGRect));
+    CGFloat *maxBottoms = malloc(capacity * sizeof(CGFloat));
+    CGFloat *minTops = malloc(capacity * sizeof(CGFloat));
+    memcpy(frames, _frames, _count * sizeof(CGRect));
+    memcpy(maxBottoms, _maxBottoms, _count * sizeof(CGFloat));
+    memcpy(minTops, _minTops, _count * sizeof(CGFloat));
+    _frames = frames;
+    _maxBottoms = maxBottoms;
+    _minTops = minTops;
+    _capacity = capacity;
+    _storage = nil;
+}
+
+#pragma mark - Frames
+
+- (void)addFrame:(CGRect)frame margin:(UIEdgeInsets)margin {
+    NSAssert(!_uniform, @"Can't add frames to a uniform frame index");
+    if (_storage || _count == _capacity) {
+        [self reserveCapacity:MAX(MAX(_capacity, _count) * 2, 16)];
+    }
+
+    CGFloat top = CGRectGetMinY(frame), bottom = CGRectGetMaxY(frame);
+    _frames[_count] = frame;
+    _maxBottoms[_count] = _count ? MAX(_maxBottoms[_count - 1], bottom) : bottom;
+
+    // keep the suffix minimums true. usually stops immediately
+    _minTops[_count] = top;
+    for (NSInteger i = (NSInteger)_count - 1; i >= 0 && _minTops[i] > top; i--) {
+        _minTops[i] = top;
+    }
+    _count++;
+
+    _extent.width = MAX(_extent.width, CGRectGetMaxX(frame) + margin.right);
+    _extent.height = MAX(_extent.height, bottom + margin.bottom);
+}
+
+- (CGRect)frameAtIndex:(NSUInteger)index {
+    if (index >= _count) {
+        return CGRectZero;
+    }
+    if (_rowEdges) {
+        NSUInteger row = index / _columns, column = index % _columns;
+        CGRect cell = {
+              _origin.x + _columnEdges[column], _origin.y + _rowEdges[row],
+              _columnEdges[column + 1] - _columnEdges[column],
+              _rowEdges[row + 1] - _rowEdges[row]
+        };
+        CGRect frame = UIEdgeInsetsInsetRect(cell, _boxMargin);
+        frame.origin = (CGPoint){roundToPixel(frame.origin.x), roundToPixel(frame.origin.y)};
+        return frame;
+    }
+    if (_uniform) {
+        NSUInteger row = index / _columns, column = index % _columns;
+        return (CGRect){
+              (CGPoint){
+                    roundToPixel(_origin.x + column * _cellSize.width + _boxMargin.left),
+                    roundToPixel(_origin.y + row * _cellSize.height + _boxMargin.top)
+              },
+              _boxSize
+        };
+    }
+    return _frames[index];
+}
+
+- (NSUInteger)memoryCost {
+
+    // mapped pages are clean, so the system can drop them without our help
+    if (_storage) {
+        return _columnCount * (sizeof(CGFloat) + sizeof(NSUInteger));
+    }
+    return _capacity * (sizeof(CGRect) + sizeof(CGFloat) * 2)
+          + _columnCount * (sizeof(CGFloat) + sizeof(NSUInteger))
+          + _rowEdgeData.length + _columnEdgeData.length;
+}
+
+#pragma mark - Lookups
+
+- (NSUInteger)firstIndexEndingBelowY:(CGFloat)y {
+    if (_uniform) {
+        NSRange rows = [self uniformRowsFrom:y to:CGFLOAT_MAX];
+        return rows.length ? MIN(rows.location * _columns, _count) : _count;
+    }
+    NSUInteger low = 0, high = _count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (_maxBottoms[mid] > y) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+- (NSUInteger)endIndexStartingAboveY:(CGFloat)y {
+    if (_uniform) {
+        NSRange rows = [self uniformRowsFrom:-CGFLOAT_MAX to:y];
+        return rows.length ? MIN(NSMaxRange(rows) * _columns, _count) : 0;
+    }
+    NSUInteger low = 0, high = _count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (_minTops[mid] >= y) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+- (NSIndexSet *)indexesOfFramesIntersectingRect:(CGRect)rect {
+    NSMutableIndexSet *indexes = NSMutableIndexSet.indexSet;
+    if (CGRectIsEmpty(rect)) {
+        return indexes;
+    }
+
+    if (_uniform) {
+        NSRange rows = [self uniformRowsFrom:CGRectGetMinY(rect) to:CGRectGetMaxY(rect)];
+        NSRange columns = [self uniformColumnsFrom:CGRectGetMinX(rect) to:CGRectGetMaxX(rect)];
+        if (!columns.length) {
+            return indexes;
+        }
+        for (NSUInteger row = rows.location; row < NSMaxRange(rows); row++) {
+            NSUInteger first = row * _columns + columns.location;
+            if (first >= _count) {
+                break;
+            }
+            [indexes addIndexesInRange:NSMakeRange(first, MIN(columns.length, _count - first))];
+        }
+        return indexes;
+    }
+
+    NSUInteger start = [self firstIndexEndingBelowY:CGRectGetMinY(rect)];
+    NSUInteger end = [self endIndexStartingAboveY:CGRectGetMaxY(rect)];
+
+    // add contiguous runs as ranges
+    NSUInteger runStart = NSNotFound;
+    for (NSUInteger i = start; i < end; i++) {
+        if (CGRectIntersectsRect(_frames[i], rect)) {
+            if (runStart == NSNotFound) {
+                runStart = i;
+            }
+        } else if (runStart != NSNotFound) {
+            [indexes addIndexesInRange:NSMakeRange(runStart, i - runStart)];
+            runStart = NSNotFound;
+        }
+    }
+    if (runStart != NSNotFound) {
+        [indexes addIndexesInRange:NSMakeRange(runStart, end - runStart)];
+    }
+
+    return indexes;
+}
+
+- (NSUInteger)indexOfFrameContainingPoint:(CGPoint)point {
+    if (_uniform) {
+        NSUInteger index = NSNotFound;
+        NSRange rows = [self uniformRowsFrom:point.y to:point.y];
+        NSRange columns = [self uniformColumnsFrom:point.x to:point.x];
+        if (rows.length && columns.length) {
+            index = rows.location * _columns + columns.location;
+        }
+        return index < _count && CGRectContainsPoint([self frameAtIndex:index], point)
+              ? index : NSNotFound;
+    }
+
+    NSUInteger start = [self firstIndexEndingBelowY:point.y];
+    NSUInteger end = [self endIndexStartingAboveY:point.y];
+    for (NSUInteger i = end; i > start; i--) {
+        if (CGRectContainsPoint(_frames[i - 1], point)) {
+            return i - 1;
+        }
+    }
+    return NSNotFound;
+}
+
+- (NSRange)uniformRowsFrom:(CGFloat)min to:(CGFloat)max {
+    if (_rowEdges) {
+        return MGEdgeSpan(min, max, _origin.y, _rowEdges, _rows, _boxMargin.top,
+              _boxMargin.bottom);
+    }
+    return MGUniformSpan(min, max, _origin.y + _boxMargin.top, _boxSize.height,
+          _cellSize.height, _rows);
+}
+
+- (NSRange)uniformColumnsFrom:(CGFloat)min to:(CGFloat)max {
+    if (_columnEdges) {
+        return MGEdgeSpan(min, max, _origin.x, _columnEdges, MIN(_columns, _count),
+              _boxMargin.left, _boxMargin.right);
+    }
+    return MGUniformSpan(min, max, _origin.x + _boxMargin.left, _boxSize.width,
+          _cellSize.width, MIN(_columns, _count));
+}
+
+#pragma mark - Masonry columns
+
+- (void)resetColumns:(NSUInteger)count top:(CGFloat)top {
+    count = MAX(count, 1);
+    _columnHeights = realloc(_columnHeights, count * sizeof(CGFloat));
+    _columnHeap = realloc(_columnHeap, count * sizeof(NSUInteger));
+    for (NSUInteger i = 0; i < count; i++) {
+        _columnHeights[i] = top;
+        _columnHeap[i] = i; // equal heights in column order is already a valid heap
+    }
+    _columnCount = count;
+}
+
+- (NSUInteger)shortestColumn {
+    return _columnCount ? _columnHeap[0] : 0;
+}
+
+- (CGFloat)heightOfColumn:(NSUInteger)column {
+    return column < _columnCount ? _columnHeights[column] : 0;
+}
+
+- (BOOL)column:(NSUInteger)a isShorterThan:(NSUInteger)b {
+    CGFloat ha = _columnHeights[a], hb = _columnHeights[b];
+    return ha < hb || (ha == hb && a < b);
+}
+
+- (void)setHeightOfShortestColumn:(CGFloat)height {
+    if (!_columnCount) {
+        return;
+    }
+    _columnHeights[_columnHeap[0]] = height;
+
+    // sift down
+    NSUInteger pos = 0;
+    while (YES) {
+        NSUInteger left = pos * 2 + 1, right = left + 1, smallest = pos;
+        if (left < _columnCount && [self column:_columnHeap[left] isShorterThan:_columnHeap[smallest]]) {
+            smallest = left;
+        }
+        if (right < _columnCount && [self column:_columnHeap[right] isShorterThan:_columnHeap[smallest]]) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            break;
+        }
+        NSUInteger swap = _columnHeap[pos];
+        _columnHeap[pos] = _columnHeap[smallest];
+        _columnHeap[smallest] = swap;
+        pos = smallest;
+    }
+}
+
+#pragma mark - Fini
+
+- (void)dealloc {
+    if (!_storage) {
+        free(_frames);
+        free(_maxBottoms);
+        free(_minTops);
+    }
+    free(_columnHeights);
+    free(_columnHeap);
+}
+
+@end
@@ -5,3 +5,10 @@
 #import "MGLine.h"
 #import "MGScrollView.h"
 #import "MGBoxProvider.h"
+#import "MGBoxReusePool.h"
+#import "MGAsyncRenderer.h"
+#import "MGAsyncLayoutScheduler.h"
+#import "MGMemoryBudget.h"
+#import "MGPerformanceHUD.h"
+#import "MGSessionRecorder.h"
+#import "MGSessionReplayer.h"
@@ -2,18 +2,32 @@
 //  Created by matt on 3/12/12.
 //
 
+#import "MGMemoryBudget.h"
+
 @protocol MGLayoutBox;
+@class MGBoxReusePool, MGBoxFrameIndex, MGSessionRecorder;
 
 typedef id (^MGBoxKeyMaker)(NSUInteger index);
+typedef uint64_t (^MGBoxIntegerKeyMaker)(NSUInteger index);
 typedef UIView <MGLayoutBox> *(^MGBoxMaker)(NSString *type);
 typedef UIView <MGLayoutBox> *(^MGBoxCustomiser)(NSUInteger index);
 typedef UIEdgeInsets(^MGBoxMarginMaker)(NSUInteger index);
 typedef CGSize(^MGBoxSizeMaker)(NSUInteger index);
+typedef CGFloat(^MGBoxDimensionMaker)(NSUInteger index);
 typedef NSUInteger(^MGCounter)(void);
+typedef void (^MGBoxPrefetcher)(NSIndexSet *indexes);
 
 typedef void (^MGBoxAnimator)(id box, NSUInteger index, NSTimeInterval duration,
       CGRect fromFrame, CGRect toFrame);
 
+typedef struct {
+    NSTimeInterval dataKeys;
+    NSTimeInterval boxFrames;
+    NSTimeInterval visibleIndexes;
+    NSTimeInterval boxes;
+    NSTimeInterval total;
+} MGLayoutTimings;
+
 /**
 Provides box reuse / offscreen culling, similar to `UITableView` cell reuse. Use a
 box provider for tables and grids with dynamic content or a large number of items,
@@ -24,9 +38,13 @@ removed. As such, they can only be used on an [MGScrollView](MGScrollView).
 
     self.scroller = [MGScrollView scrollerWithSize:self.view.size];
     self.scroller.boxProvider = MGBoxProvider.provider;
+
+Providers are registered with the <MGMemoryBudget>. Their frames are reported
+in usage, and saved state for offscreen nested scrollers is dropped when
+trimming.
 */
 
-@interface MGBoxProvider : NSObject
+@interface MGBoxProvider : NSObject <MGTrimmableCache>
 
 #pragma mark - Initialisation
 
@@ -59,7 +77,9 @@ block.
 
 /**
 Should return a unique key for the given index. Must conform to `NSCopying`, thus
-will usually be an `NSString` or `NSNumber`.
+will usually be an `NSString` or `NSNumber`. Duplicate keys assert in debug
+builds. In release builds they make the provider treat all the data as new for
+that layout.
 
     boxProvider.boxKeyMaker = ^id(NSUInteger index) {
         return [self.items[index] uniqueId];
@@ -67,6 +87,21 @@ will usually be an `NSString` or `NSNumber`.
 */
 @property (nonatomic, copy) MGBoxKeyMaker boxKeyMaker;
 
+/**
+An alternative to <boxKeyMaker> for data identified by 64 bit integers (eg
+database row ids). Keys are kept in flat hash tables instead of as objects, so
+diffing large lists is faster and uses less memory. Use one or the other, not
+both.
+
+    boxProvider.boxIntegerKeyMaker = ^uint64_t(NSUInteger index) {
+        return self.rows[index].rowId;
+    };
+
+Where a data key object is needed (eg for
+[asyncDisplayKey](-[MGBox asyncDisplayKey])), the key is an `NSNumber`.
+*/
+@property (nonatomic, copy) MGBoxIntegerKeyMaker boxIntegerKeyMaker;
+
 /**
 Should return a `CGSize` for the box at the given index.
 
@@ -136,6 +171,179 @@ Should return the total number of items in the table or grid.
 */
 - (UIView <MGLayoutBox> *)boxOfType:(NSString *)type;
 
+#pragma mark - Masonry layout
+
+/** @name Masonry layout */
+
+/**
+* The number of columns used when the container's
+* [contentLayoutMode](-[MGLayoutBox contentLayoutMode]) is
+* `MGLayoutMasonryStyle`, or for a grid of <uniformBoxSize> boxes. The default
+* of zero fits as many columns as the first box's width (plus margins) allows.
+* Two dimensional grids need it set (see <rowHeightMaker>).
+*/
+@property (nonatomic, assign) NSUInteger columnCount;
+
+#pragma mark - Uniform grids
+
+/** @name Uniform grids */
+
+/**
+For grids where every box has the same size and margins (eg photo pickers),
+assign the box size here instead of providing a <boxSizeMaker> and
+<boxMarginMaker>. Frames, content size, and visible indexes are then computed
+arithmetically from each index, with no per-box storage, so layout and rotation
+cost only depends on the number of visible boxes.
+
+    boxProvider.uniformBoxSize = (CGSize){78, 78};
+    boxProvider.uniformBoxMargin = UIEdgeInsetsMake(2, 2, 0, 0);
+    boxProvider.columnCount = 4; // or leave as 0 to fit to the container width
+
+Columns are only used in `MGLayoutGridStyle` and `MGLayoutMasonryStyle`. In
+`MGLayoutTableStyle` each box gets its own row.
+
+@note For O(visible) reloads, also leave <boxKeyMaker> unset, so that data keys
+are the indexes themselves and don't need collecting.
+*/
+@property (nonatomic, assign) CGSize uniformBoxSize;
+
+/**
+* The margins of every box when using <uniformBoxSize>, or within its cell when
+* using <rowHeightMaker> and <columnWidthMaker>.
+*/
+@property (nonatomic, assign) UIEdgeInsets uniformBoxMargin;
+
+#pragma mark - Two dimensional grids
+
+/** @name Two dimensional grids */
+
+/**
+For spreadsheets, timelines, and other grids of rows and columns that can be
+larger than the container in both directions. Give the number of columns in
+<columnCount>, the total number of cells from <counter>, and each row's height
+and each column's width here instead of a <boxSizeMaker>. The box at index `i`
+is in row `i / columnCount` and column `i % columnCount`.
+
+    boxProvider.columnCount = self.columns.count;
+    boxProvider.counter = ^{
+        return self.rows.count * self.columns.count;
+    };
+    boxProvider.rowHeightMaker = ^(NSUInteger row) {
+        return row ? 32 : 44; // taller header row
+    };
+    boxProvider.columnWidthMaker = ^(NSUInteger column) {
+        return [self.columns[column] width];
+    };
+
+Rows don't wrap to the container width, so the content size is the total of
+the column widths, and the container scrolls both ways. Only the row and column
+edges are stored, and visible indexes are found by binary searching them along
+both axes, so memory grows with rows plus columns, not cells, and each scroll
+costs only as much as the cells in the viewport. Boxes scrolled out in either
+direction go back to the <reusePool>.
+
+Either block can be left unset to give every row or column the height or width
+of <uniformBoxSize>. The container's
+[contentLayoutMode](-[MGLayoutBox contentLayoutMode]) is ignored.
+
+@note As with uniform grids, leave <boxKeyMaker> unset for O(visible) reloads.
+*/
+@property (nonatomic, copy) MGBoxDimensionMaker rowHeightMaker;
+
+/**
+* Should return the width of the given column of a two dimensional grid. See
+* <rowHeightMaker>.
+*/
+@property (nonatomic, copy) MGBoxDimensionMaker columnWidthMaker;
+
+#pragma mark - Prefetching
+
+/** @name Prefetching */
+
+/**
+Called with the indexes of boxes about to enter the viewport, so that remote
+images or expensive data can be fetched before the boxes are customised. The
+look-ahead window extends <prefetchDistance> beyond the buffered viewport in the
+direction of scrolling, plus however far the current scroll velocity will travel
+in the next 0.3 seconds. Each index is only passed once while it stays in the
+window.
+
+    boxProvider.boxPrefetcher = ^(NSIndexSet *indexes) {
+        [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+            [self.imageLoader loadImageForItem:self.items[index]];
+        }];
+    };
+*/
+@property (nonatomic, copy) MGBoxPrefetcher boxPrefetcher;
+
+/**
+Called with previously prefetched indexes that left the look-ahead window
+without appearing on screen (eg when a fast fling changes direction), or whose
+data was reloaded, so that their pending work can be cancelled.
+
+    boxProvider.boxPrefetchCanceller = ^(NSIndexSet *indexes) {
+        [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+            [self.imageLoader cancelLoadForItem:self.items[index]];
+        }];
+    };
+*/
+@property (nonatomic, copy) MGBoxPrefetcher boxPrefetchCanceller;
+
+/**
+* How far beyond the buffered viewport to prefetch, in points. When not
+* scrolling, the window extends this far in both directions. Default is 400.
+*/
+@property (nonatomic, assign) CGFloat prefetchDistance;
+
+/**
+* Indexes passed to the <boxPrefetcher> that haven't yet appeared or been
+* cancelled.
+*/
+@property (nonatomic, readonly) NSIndexSet *prefetchedIndexes;
+
+#pragma mark - Box reuse
+
+/** @name Box reuse */
+
+/**
+* The pool that offscreen boxes are returned to, and that
+* [boxOfType:](-[MGBoxProvider boxOfType:]) draws from. Each provider has its own
+* pool by default. Assign the same pool to several providers to share reusable
+* boxes between them.
+*/
+@property (nonatomic, strong) MGBoxReusePool *reusePool;
+
+#pragma mark - Nested providers
+
+/** @name Nested providers */
+
+/**
+Binds a nested provider-backed scroller (eg a horizontal carousel inside a table
+row) to the data at the given index. Call this from inside your <boxCustomiser>,
+after configuring the nested scroller's own provider for the new data.
+
+    boxProvider.boxCustomiser = ^(NSUInteger index) {
+        CarouselRow *row = (id)[boxProvider boxOfType:@"Carousel"];
+        row.items = self.sections[index].items;
+        [boxProvider prepareNestedScroller:row.carousel forIndex:index];
+        return row;
+    };
+
+If the scroller was previously bound to other data, its frames and scroll offset
+are kept for that data until it is bound again, so that carousels recycled
+offscreen come back exactly as they were left. Nested providers share the
+<nestedReusePool>, and their layout is deferred until their row is actually
+inside the visible viewport.
+*/
+- (void)prepareNestedScroller:(UIScrollView <MGLayoutBox> *)scroller
+      forIndex:(NSUInteger)index;
+
+/**
+* The reuse pool shared by all nested scrollers passed to
+* [prepareNestedScroller:forIndex:](-[MGBoxProvider prepareNestedScroller:forIndex:]).
+*/
+@property (nonatomic, strong) MGBoxReusePool *nestedReusePool;
+
 #pragma mark - Visible indexes and boxes
 
 /** @name Visible indexes and boxes */
@@ -150,6 +358,114 @@ Should return the total number of items in the table or grid.
 */
 @property (nonatomic, readonly) NSDictionary *visibleBoxes;
 
+#pragma mark - Batch updates
+
+/** @name Batch updates */
+
+/**
+Coalesces all container layouts requested inside the `updates` block into a
+single layout at the end of the block, with one data key diff, one frame pass,
+and one animated reconcile. The layout uses the longest duration requested in
+the block, and the completion blocks of the requested layouts are all called
+when it finishes, followed by `completion`.
+
+    [scroller.boxProvider performBatchUpdates:^{
+        for (Change *change in changes) {
+            [self applyChange:change];
+            [scroller layoutWithDuration:0.3 completion:nil];
+        }
+    } completion:nil];
+
+Layouts requested while an animated layout is still running are coalesced in
+the same way, and run once the animation finishes. Batches can be nested, with
+the layout waiting for the outermost batch to end.
+
+If no layout is requested in the block, `completion` is called straight away.
+*/
+- (void)performBatchUpdates:(MGBlock)updates completion:(MGBlock)completion;
+
+/**
+* YES while inside a <performBatchUpdates:completion:> block.
+*/
+@property (nonatomic, readonly) BOOL performingBatchUpdates;
+
+#pragma mark - Layout cache
+
+/** @name Layout cache */
+
+/**
+A file path for keeping the provider's data keys, frames, and scroll offset
+between launches. When set, the first layout maps the file and shows the
+remembered viewport straight away, without calling the key, size, and margin
+blocks for every item. The file is only used if the item count, container
+width, and content layout mode all match.
+
+The cached keys and frames are then checked against the live data over the
+following run loop passes, with frames restacked from the live sizes, margins,
+and padding. If anything differs, the cache is dropped and the container is laid
+out again from the live data.
+
+    provider.layoutCachePath = [NSTemporaryDirectory()
+          stringByAppendingPathComponent:@"feed.layout"];
+
+The cache is saved when the app enters the background, or by calling
+<saveLayoutCache>. Data keys need to conform to `NSCoding` to be validated;
+otherwise only the frames are checked.
+*/
+@property (nonatomic, copy) NSString *layoutCachePath;
+
+/**
+* Writes the current data keys, frames, and scroll offset to <layoutCachePath>.
+* The file is written on a background queue.
+*/
+- (void)saveLayoutCache;
+
+#pragma mark - Session recording
+
+/** @name Session recording */
+
+/**
+* Records the provider's `counter`, key, size, and margin results, and its
+* container's layout passes and scroll offsets, to a trace file that
+* <MGSessionReplayer> can replay without the app. Set it after the provider's
+* blocks, and set it back to `nil` to finish the trace. Default is `nil`.
+
+    provider.sessionRecorder = [MGSessionRecorder recorderWithPath:path];
+*/
+@property (nonatomic, strong) MGSessionRecorder *sessionRecorder;
+
+#pragma mark - Stats
+
+/** @name Stats */
+
+/**
+* The number of boxes currently on the container, including those in the
+* buffered area outside the visible viewport.
+*/
+@property (nonatomic, readonly) NSUInteger liveBoxCount;
+
+/**
+* The highest <liveBoxCount> since the provider was created or
+* <resetPeakLiveBoxCount> was called. Useful for tuning
+* [viewportMargin](-[MGScrollView viewportMargin]) and
+* [maxViewportMargin](-[MGScrollView maxViewportMargin]).
+*/
+@property (nonatomic, readonly) NSUInteger peakLiveBoxCount;
+
+/**
+* The number of offscreen boxes waiting in the <reusePool>.
+*/
+@property (nonatomic, readonly) NSUInteger pooledBoxCount;
+
+- (void)resetPeakLiveBoxCount;
+
+/**
+* How long each stage of the most recent layout pass took, in seconds. Scroll
+* driven passes only update the visible indexes and boxes, so report zero for
+* the other stages. `boxes` includes the time spent in <boxCustomiser>.
+*/
+@property (nonatomic, readonly) MGLayoutTimings lastLayoutTimings;
+
 #pragma mark - Custom animations
 
 /** @name Custom animations */
@@ -158,6 +474,10 @@ Should return the total number of items in the table or grid.
 An optional custom animation block for new boxes appearing on screen for the first
 time. Note that this does not include boxes appearing on screen due to scrolling.
 
+Custom animation blocks are called outside the layout pass's animation
+transaction, so should run their own animations. The built in animations are
+grouped into the pass's single transaction.
+
     boxProvider.appearAnimation = ^(MGBox *box, NSUInteger index,
           NSTimeInterval duration, CGRect fromFrame, CGRect toFrame) {
         box.alpha = 0;
@@ -195,6 +515,14 @@ box is inserted before it.
 */
 @property (nonatomic, copy) MGBoxAnimator moveAnimation;
 
+/**
+* Boxes that are outside the viewport both before and after an animated layout
+* snap into place without animating. If more than this many on screen boxes
+* would animate, the layout crossfades the whole container instead. Default is
+* 100. Set to 0 to always animate.
+*/
+@property (nonatomic, assign) NSUInteger maxAnimatedChanges;
+
 #pragma mark - Relationships
 
 /** @name Relationships */
@@ -209,6 +537,7 @@ box is inserted before it.
 /** @name Internal */
 
 @property (nonatomic, assign) BOOL lockVisibleIndexes;
+@property (nonatomic, assign) BOOL nestedLayoutDeferred;
 
 - (void)doAppearAnimationFor:(UIView <MGLayoutBox> *)box atIndex:(NSUInteger)index
       duration:(NSTimeInterval)duration;
@@ -220,10 +549,13 @@ box is inserted before it.
 - (void)updateDataKeys;
 - (void)updateBoxFrames;
 - (void)updateVisibleIndexes;
-- (void)updateVisibleBoxes:(NSMutableDictionary *)visibleBoxes
-      boxToIndexMap:(NSMapTable *)boxToIndexMap;
+- (void)updatePrefetchIndexes;
+- (void)updateVisibleBoxes:(NSMutableDictionary *)visibleBoxes;
 - (void)updateOldDataKeys;
 - (void)updateOldBoxFrames;
+- (void)updateAppendedDataKeys;
+- (void)updateAppendedBoxFrames;
+- (void)updateBoxFramesThroughIndex:(NSUInteger)index height:(CGFloat)height;
 
 - (NSUInteger)count;
 
@@ -238,11 +570,35 @@ box is inserted before it.
 - (BOOL)dataWasRemovedForBox:(UIView <MGLayoutBox> *)box;
 
 // frames
+- (MGBoxFrameIndex *)boxFrames;
+- (CGSize)estimatedBoxFramesExtent;
+- (BOOL)hasUniformBoxes;
+- (BOOL)hasGridBoxes;
 - (CGSize)sizeForBoxAtIndex:(NSUInteger)index;
 - (UIEdgeInsets)marginForBoxAtIndex:(NSUInteger)index;
 - (CGRect)frameForBoxAtIndex:(NSUInteger)index;
 - (CGRect)oldFrameForBoxAtIndex:(NSUInteger)index;
 
+// data keys
+- (id)keyForBoxAtIndex:(NSUInteger)index;
+- (NSUInteger)indexOfDataKey:(id)key;
+
+// async display
+- (id)displayKeyForBoxAtIndex:(NSUInteger)index;
+
+// layout coalescing
+- (BOOL)deferLayoutWithDuration:(NSTimeInterval)duration completion:(MGBlock)completion;
+- (void)layoutAnimationDidStart;
+- (void)layoutAnimationDidEnd;
+
+// stats
+- (void)recordLayoutTimings:(MGLayoutTimings)timings;
+
+// nested providers
+- (id)nestedState;
+- (void)restoreNestedState:(id)state;
+- (void)layoutNestedScrollers;
+
 - (void)resetBoxCache;
 - (void)reset;
 
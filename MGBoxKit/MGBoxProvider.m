@@ -4,19 +4,74 @@
 
 #import "MGBoxProvider.h"
 #import "MGLayoutBox.h"
+#import "MGBox.h"
 #import "MGLayoutManager.h"
+#import "MGBoxReusePool.h"
+#import "MGBoxFrameIndex.h"
+#import "MGScrollView.h"
+#import "MGAsyncLayoutScheduler.h"
+#import "MGLayoutCache.h"
+#import "MGIntegerKeyTable.h"
+#import "MGSessionRecorder.h"
+
+// seconds of scroll velocity to add to the prefetch distance
+#define PREFETCH_LEAD_TIME 0.3
+
+// frames stacked at a time while catching up to the viewport
+#define FRAME_STACK_CHUNK 32
+
+// frames stacked per run loop pass when finishing a partial restack
+#define FRAME_STACK_BATCH 500
+
+// items checked per run loop pass when validating a loaded layout cache
+#define LAYOUT_CACHE_VALIDATION_BATCH 500
+
+// a nested provider's data keys, frames, and scroll offset, kept while its
+// scroller is bound to other data
+@interface MGBoxProviderState : NSObject
+@property (nonatomic, strong) NSMutableOrderedSet *dataKeys;
+@property (nonatomic, strong) MGIntegerKeyTable *integerKeys;
+@property (nonatomic, strong) MGBoxFrameIndex *boxFrames;
+@property (nonatomic, assign) NSUInteger count;
+@property (nonatomic, assign) CGFloat containerWidth;
+@property (nonatomic, assign) CGPoint contentOffset;
+@end
+
+@implementation MGBoxProviderState
+@end
 
 @implementation MGBoxProvider {
-    NSMapTable *_boxToIndexMap, *_oldBoxToIndexMap;
-    NSOrderedSet *_dataKeys, *_oldDataKeys, *_removedDataKeys;
-    NSOrderedSet *_boxFrames, *_oldBoxFrames;
-    NSMutableOrderedSet *_boxCache;
+    MGIntegerKeyTable *_boxToIndexMap, *_oldBoxToIndexMap;
+    NSDictionary *_oldVisibleBoxes;
+    NSMutableOrderedSet *_dataKeys;
+    NSOrderedSet *_oldDataKeys, *_removedDataKeys;
+    MGIntegerKeyTable *_integerKeys, *_oldIntegerKeys;
+    MGBoxFrameIndex *_boxFrames, *_oldBoxFrames;
+    CGFloat _boxFramesWidth;
+    NSUInteger _dataKeyCount, _oldDataKeyCount;
     NSUInteger _count;
+    MGBoxProviderState *_restoredState;
+    NSMapTable *_nestedScrollerKeys;
+    NSMutableDictionary *_nestedStates;
+    NSHashTable *_pendingNestedScrollers;
+    NSUInteger _batchDepth, _runningLayoutAnimations;
+    BOOL _layoutRequested, _deferredLayoutScheduled;
+    NSTimeInterval _requestedDuration;
+    NSMutableArray *_requestedCompletions;
+    BOOL _layoutCacheTried;
+    MGLayoutCache *_validatingLayoutCache;
+    NSMutableOrderedSet *_validatedDataKeys;
+    MGIntegerKeyTable *_validatedIntegerKeys;
+    MGBoxFrameIndex *_validatedFrames;
+    NSUInteger _validatedCount;
 }
 
 - (id)init {
     self = [super init];
+    self.prefetchDistance = 400;
+    self.maxAnimatedChanges = 100;
     [self reset];
+    [MGMemoryBudget.sharedBudget registerCache:self];
     return self;
 }
 
@@ -25,80 +80,474 @@
 }
 
 - (void)resetBoxCache {
-    _boxCache = NSMutableOrderedSet.orderedSet;
+    [self.reusePool removeAllBoxes];
 }
 
 - (void)reset {
     _count = NSNotFound;
-    _boxCache = NSMutableOrderedSet.orderedSet;
+    [self resetBoxCache];
+    _restoredState = nil;
+    _nestedScrollerKeys = NSMapTable.weakToStrongObjectsMapTable;
+    _nestedStates = NSMutableDictionary.new;
+    _pendingNestedScrollers = NSHashTable.weakObjectsHashTable;
     _oldBoxToIndexMap = nil;
     _boxToIndexMap = nil;
+    _oldVisibleBoxes = nil;
     _visibleIndexes = nil;
+    _boxFrames = nil;
     _oldBoxFrames = nil;
     _oldDataKeys = nil;
     _removedDataKeys = nil;
     _dataKeys = nil;
+    _integerKeys = nil;
+    _oldIntegerKeys = nil;
+    _dataKeyCount = NSNotFound;
+    _oldDataKeyCount = NSNotFound;
+    _validatingLayoutCache = nil;
+    [self cancelPrefetches];
 }
 
 #pragma mark - Internal state list updates
 
+// prefetches are only cancelled for indexes whose data key changed
 - (void)updateDataKeys {
+    NSIndexSet *prefetched = _prefetchedIndexes;
+    NSArray *prefetchedKeys = [self storedDataKeysAtIndexes:prefetched];
+    [self updateDataKeysFromData];
+    [self cancelPrefetchesAtIndexes:prefetched changedFromKeys:prefetchedKeys];
+}
+
+- (void)updateDataKeysFromData {
     _count = NSNotFound;
+
+    // first layout? then try the layout cache from the last launch
+    if (!_layoutCacheTried && !_boxFrames && self.layoutCachePath) {
+        _layoutCacheTried = YES;
+        [self loadLayoutCache];
+    }
+
+    // restored nested state is trusted while the data still matches it
+    if (_restoredState) {
+        if ([self restoredStateMatchesData]) {
+            _removedDataKeys = nil;
+            return;
+        }
+        _restoredState = nil;
+    }
+    _validatingLayoutCache = nil;
+    NSAssert(!self.boxKeyMaker || !self.boxIntegerKeyMaker, @"Set either boxKeyMaker or "
+          "boxIntegerKeyMaker, not both");
+
+    // without a key maker the keys are the indexes, so there's nothing to store
+    if (!self.boxKeyMaker && !self.boxIntegerKeyMaker) {
+        if (_oldDataKeys || _oldIntegerKeys) {
+            _oldDataKeys = nil;
+            _oldIntegerKeys = nil;
+            _oldDataKeyCount = NSNotFound;
+        }
+        _dataKeys = nil;
+        _integerKeys = nil;
+        _dataKeyCount = self.count;
+        _removedDataKeys = nil;
+        return;
+    }
+
+    // integer keys go in flat tables, and removals are found by lookup
+    if (self.boxIntegerKeyMaker) {
+        if (!_oldIntegerKeys) {
+            _oldDataKeyCount = NSNotFound;
+        }
+        MGIntegerKeyTable *keys = [MGIntegerKeyTable tableWithCapacity:self.count];
+        for (NSUInteger i = 0; i < self.count; i++) {
+            if (![keys addKey:self.boxIntegerKeyMaker(i)]) {
+                NSAssert(NO, @"Duplicate data key at index %d. boxIntegerKeyMaker must "
+                      "return unique values.", (int)i);
+                [self useIndexKeysForDuplicates];
+                return;
+            }
+        }
+        _dataKeys = _oldDataKeys = nil;
+        _integerKeys = keys;
+        _dataKeyCount = keys.count;
+        _removedDataKeys = nil;
+        return;
+    }
+    _integerKeys = _oldIntegerKeys = nil;
+    if (!_oldDataKeys) {
+        _oldDataKeyCount = NSNotFound;
+    }
+
     NSMutableOrderedSet *dataKeys = [NSMutableOrderedSet orderedSetWithCapacity:self.count];
     for (int i = 0; i < self.count; i++) {
         [dataKeys addObject:[self keyForBoxAtIndex:i]];
     }
 
-    NSAssert(dataKeys.count == self.count, @"Expected %d data keys but have %d. boxKeyMaker "
-          "must return unique values.", (int)self.count, (int)dataKeys.count);
+    if (dataKeys.count != self.count) {
+        NSAssert(NO, @"Expected %d data keys but have %d. boxKeyMaker must return unique "
+              "values.", (int)self.count, (int)dataKeys.count);
+        [self useIndexKeysForDuplicates];
+        return;
+    }
 
     _dataKeys = dataKeys;
+    _dataKeyCount = dataKeys.count;
     NSMutableOrderedSet *removed = _oldDataKeys.mutableCopy;
     [removed minusOrderedSet:_dataKeys];
     _removedDataKeys = removed;
 }
 
+// duplicate keys would put every later key at the wrong index, so in release
+// builds the keys are dropped for this pass, and all the data counts as new.
+// the next update tries the key maker again
+- (void)useIndexKeysForDuplicates {
+    _dataKeys = _oldDataKeys = nil;
+    _integerKeys = _oldIntegerKeys = nil;
+    _dataKeyCount = self.count;
+    _oldDataKeyCount = NSNotFound;
+    _removedDataKeys = nil;
+}
+
+// same count, and the same keys for the first and last boxes the restored
+// frames would show. data that changed in place shows up in one or the other
+- (BOOL)restoredStateMatchesData {
+    MGBoxProviderState *state = _restoredState;
+    if (self.count != state.count) {
+        return NO;
+    }
+
+    // index keys have nothing to compare, and a layout cache is validated later
+    if (!state.count || (!state.dataKeys && !state.integerKeys)) {
+        return YES;
+    }
+    if ((state.integerKeys != nil) != (self.boxIntegerKeyMaker != nil)
+          || (state.dataKeys != nil) != (self.boxKeyMaker != nil)) {
+        return NO;
+    }
+
+    NSIndexSet *visible = [state.boxFrames
+          indexesOfFramesIntersectingRect:self.container.bufferedViewport];
+    NSUInteger ends[2] = {
+        visible.count ? visible.firstIndex : 0,
+        visible.count ? visible.lastIndex : state.count - 1
+    };
+    for (int i = 0; i < 2; i++) {
+        NSUInteger index = ends[i];
+        BOOL same = state.integerKeys
+              ? [state.integerKeys keyAtIndex:index] == self.boxIntegerKeyMaker(index)
+              : [state.dataKeys[index] isEqual:self.boxKeyMaker(index)];
+        if (!same) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
 - (void)updateBoxFrames {
+    if (_restoredState) {
+        BOOL sameWidth = _restoredState.containerWidth == self.container.width;
+        _restoredState = nil;
+        if (sameWidth) {
+            return;
+        }
+    }
+    _validatingLayoutCache = nil;
     _boxFrames = [MGLayoutManager framesForBoxesIn:self.container];
+    _boxFramesWidth = self.container.width;
+}
+
+- (void)updateBoxFramesThroughIndex:(NSUInteger)index height:(CGFloat)height {
+    BOOL restored = _restoredState && _restoredState.containerWidth == self.container.width;
+    if (index == NSNotFound || index >= self.count || self.hasUniformBoxes || restored) {
+        [self updateBoxFrames];
+        return;
+    }
+
+    // the keys were just updated, and an insert or a changed size anywhere
+    // above the index moves everything after it, so restack from the top. but
+    // only as far as the index plus a screenful. the rest is stacked later
+    _restoredState = nil;
+    _validatingLayoutCache = nil;
+    _boxFrames = [MGBoxFrameIndex frameIndexWithCapacity:self.count];
+    _boxFramesWidth = self.container.width;
+    [MGLayoutManager stackFramesIn:self.container into:_boxFrames count:index + 1];
+    [self stackBoxFramesThroughY:CGRectGetMinY([_boxFrames frameAtIndex:index]) + height];
+    [self finishBoxFramesLater];
+}
+
+- (BOOL)boxFramesIncomplete {
+    return _boxFrames && !_boxFrames.uniform && _boxFrames.count < self.count;
+}
+
+// stacks until the last frame starts below y. boxes are added in order (or
+// to the shortest masonry column), so every frame above y is then stacked
+- (void)stackBoxFramesThroughY:(CGFloat)y {
+    while (self.boxFramesIncomplete && (!_boxFrames.count
+          || CGRectGetMinY([_boxFrames frameAtIndex:_boxFrames.count - 1]) <= y)) {
+        [MGLayoutManager stackFramesIn:self.container into:_boxFrames
+              count:_boxFrames.count + FRAME_STACK_CHUNK];
+    }
+}
+
+- (void)finishBoxFramesLater {
+    if (!self.boxFramesIncomplete) {
+        return;
+    }
+    MGBoxFrameIndex *frames = _boxFrames;
+    __weak MGBoxProvider *me = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [me finishBoxFrames:frames];
+    });
+}
+
+- (void)finishBoxFrames:(MGBoxFrameIndex *)frames {
+
+    // restacked or reset in the meantime?
+    if (frames != _boxFrames || !self.boxFramesIncomplete) {
+        return;
+    }
+    [MGLayoutManager stackFramesIn:self.container into:_boxFrames
+          count:_boxFrames.count + FRAME_STACK_BATCH];
+
+    self.lockVisibleIndexes = YES;
+    [MGLayoutManager updateContentSizeFor:self.container];
+    self.lockVisibleIndexes = NO;
+
+    [self finishBoxFramesLater];
+}
+
+// keys are appended in place, and the old keys are then set to the same keys,
+// so that appended items count as existing data (see dataAtIndexIsExisting:)
+- (void)updateAppendedDataKeys {
+    NSUInteger from = _dataKeyCount;
+    _count = NSNotFound;
+    if (from == NSNotFound || self.count < from || (self.boxKeyMaker == nil) != (_dataKeys == nil)
+          || (self.boxIntegerKeyMaker == nil) != (_integerKeys == nil)) {
+        [self updateDataKeys];
+        return;
+    }
+    if (self.boxIntegerKeyMaker) {
+        for (NSUInteger i = from; i < self.count; i++) {
+            if (![_integerKeys addKey:self.boxIntegerKeyMaker(i)]) {
+                NSAssert(NO, @"Duplicate data key at index %d. boxIntegerKeyMaker must "
+                      "return unique values.", (int)i);
+                [self useIndexKeysForDuplicates];
+                return;
+            }
+        }
+        _dataKeyCount = _integerKeys.count;
+        _oldIntegerKeys = _integerKeys;
+        _removedDataKeys = nil;
+        return;
+    }
+    if (!self.boxKeyMaker) {
+        _dataKeyCount = self.count;
+        return;
+    }
+
+    for (NSUInteger i = from; i < self.count; i++) {
+        [_dataKeys addObject:[self keyForBoxAtIndex:i]];
+    }
+    if (_dataKeys.count != self.count) {
+        NSAssert(NO, @"Expected %d data keys but have %d. boxKeyMaker must return unique "
+              "values.", (int)self.count, (int)_dataKeys.count);
+        [self useIndexKeysForDuplicates];
+        return;
+    }
+    _dataKeyCount = _dataKeys.count;
+    _oldDataKeys = _dataKeys;
+    _removedDataKeys = nil;
 }
 
+- (void)updateAppendedBoxFrames {
+
+    // cached frames don't have the masonry column state to append from
+    if (!_boxFrames || _boxFrames.uniform || _boxFrames.mapped || _boxFrames.count > self.count) {
+        [self updateBoxFrames];
+        return;
+    }
+    [MGLayoutManager stackFramesIn:self.container into:_boxFrames];
+    _boxFramesWidth = self.container.width;
+
+    // appended items are existing data (see updateAppendedDataKeys), so their
+    // old frames are their new ones
+    _oldBoxFrames = _boxFrames;
+}
+
+// old and current keys share storage until the next full update replaces the
+// current ones. only updateAppendedDataKeys changes keys in place, and it sets
+// the old keys itself
 - (void)updateOldDataKeys {
     _oldDataKeys = _dataKeys;
+    _oldIntegerKeys = _integerKeys;
+    _oldDataKeyCount = _dataKeyCount;
 }
 
+// as with keys, old and current frames share storage. frames are only added
+// in place, after those the old keys refer to
 - (void)updateOldBoxFrames {
     _oldBoxFrames = _boxFrames;
 }
 
 - (void)updateVisibleIndexes {
-    if (self.lockVisibleIndexes) {
+    if (self.lockVisibleIndexes || self.nestedLayoutDeferred) {
         return;
     }
     CGRect viewport = self.container.bufferedViewport;
-    NSMutableIndexSet *visibleIndexes = NSMutableIndexSet.indexSet;
-    for (int i = 0; i < self.count; i++) {
-        if (CGRectIntersectsRect([self frameForBoxAtIndex:i], viewport)) {
-            [visibleIndexes addIndex:i];
+    [self stackBoxFramesThroughY:CGRectGetMaxY(viewport)];
+    _visibleIndexes = [_boxFrames indexesOfFramesIntersectingRect:viewport]
+          ?: NSIndexSet.indexSet;
+}
+
+- (void)updatePrefetchIndexes {
+    if (!self.boxPrefetcher || !_boxFrames || self.nestedLayoutDeferred) {
+        return;
+    }
+
+    MGScrollView *scroller = (id)self.container;
+    CGPoint velocity = [scroller isKindOfClass:MGScrollView.class]
+          ? scroller.scrollVelocity : CGPointZero;
+    CGRect window = self.container.bufferedViewport;
+
+    // extend ahead of the scroll direction, or both ways when at rest
+    CGFloat aheadY = self.prefetchDistance + fabs(velocity.y) * PREFETCH_LEAD_TIME;
+    CGFloat aheadX = self.prefetchDistance + fabs(velocity.x) * PREFETCH_LEAD_TIME;
+    if (velocity.y > 0) {
+        window.size.height += aheadY;
+    } else if (velocity.y < 0) {
+        window.origin.y -= aheadY;
+        window.size.height += aheadY;
+    } else if (!velocity.x) {
+        window = CGRectInset(window, 0, -aheadY);
+    }
+    if (velocity.x > 0) {
+        window.size.width += aheadX;
+    } else if (velocity.x < 0) {
+        window.origin.x -= aheadX;
+        window.size.width += aheadX;
+    } else if (!velocity.y) {
+        window = CGRectInset(window, -aheadX, 0);
+    }
+
+    NSMutableIndexSet *ahead = [_boxFrames indexesOfFramesIntersectingRect:window].mutableCopy;
+    [ahead removeIndexes:self.visibleIndexes];
+
+    NSMutableIndexSet *fresh = ahead.mutableCopy;
+    [fresh removeIndexes:_prefetchedIndexes];
+
+    // left the window without appearing
+    NSMutableIndexSet *gone = _prefetchedIndexes.mutableCopy;
+    [gone removeIndexes:ahead];
+    [gone removeIndexes:self.visibleIndexes];
+
+    _prefetchedIndexes = ahead;
+    if (gone.count && self.boxPrefetchCanceller) {
+        self.boxPrefetchCanceller(gone);
+    }
+    if (fresh.count) {
+        self.boxPrefetcher(fresh);
+    }
+}
+
+// the keys stored by the last key update, with NSNull where there's none
+- (NSArray *)storedDataKeysAtIndexes:(NSIndexSet *)indexes {
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:indexes.count];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        id key;
+        if (_dataKeyCount == NSNotFound || index >= _dataKeyCount) {
+            key = nil;
+        } else if (self.boxIntegerKeyMaker) {
+            key = index < _integerKeys.count ? @([_integerKeys keyAtIndex:index]) : nil;
+        } else if (self.boxKeyMaker) {
+            key = index < _dataKeys.count ? _dataKeys[index] : nil;
+        } else {
+            key = @(index);
         }
+        [keys addObject:key ?: NSNull.null];
+    }];
+    return keys;
+}
+
+- (void)cancelPrefetchesAtIndexes:(NSIndexSet *)indexes changedFromKeys:(NSArray *)oldKeys {
+    if (!indexes.count) {
+        return;
+    }
+    NSArray *keys = [self storedDataKeysAtIndexes:indexes];
+    NSMutableIndexSet *changed = NSMutableIndexSet.indexSet;
+    __block NSUInteger i = 0;
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        if (keys[i] == NSNull.null || ![keys[i] isEqual:oldKeys[i]]) {
+            [changed addIndex:index];
+        }
+        i++;
+    }];
+    if (!changed.count) {
+        return;
+    }
+
+    NSMutableIndexSet *kept = _prefetchedIndexes.mutableCopy;
+    [kept removeIndexes:changed];
+    _prefetchedIndexes = kept;
+    if (self.boxPrefetchCanceller) {
+        self.boxPrefetchCanceller(changed);
+    }
+}
+
+- (void)cancelPrefetches {
+    NSIndexSet *pending = _prefetchedIndexes;
+    _prefetchedIndexes = nil;
+    if (pending.count && self.boxPrefetchCanceller) {
+        self.boxPrefetchCanceller(pending);
     }
-    _visibleIndexes = visibleIndexes;
 }
 
-- (void)updateVisibleBoxes:(NSMutableDictionary *)visibleBoxes
-             boxToIndexMap:(NSMapTable *)boxToIndexMap {
+- (void)updateVisibleBoxes:(NSMutableDictionary *)visibleBoxes {
+
+    // the old boxes are kept alive with the old map, so their pointers stay unique
     _oldBoxToIndexMap = _boxToIndexMap;
+    _oldVisibleBoxes = _visibleBoxes;
+
+    MGIntegerKeyTable *boxToIndexMap = [MGIntegerKeyTable tableWithCapacity:visibleBoxes.count];
+    [visibleBoxes enumerateKeysAndObjectsUsingBlock:^(NSNumber *index, id box, BOOL *stop) {
+        [boxToIndexMap setIndex:index.unsignedIntegerValue forKey:MGPointerKey(box)];
+    }];
 
     // throw any gone boxes into the cache
     for (UIView <MGLayoutBox> *box in self.visibleBoxes.allValues) {
-        if (![visibleBoxes.allValues containsObject:box] && box.cacheKey) {
-            [_boxCache addObject:box];
+        if (![boxToIndexMap containsKey:MGPointerKey(box)]) {
+            [self.reusePool enqueueBox:box];
         }
     }
 
     // boxes should now be true to the data
     _visibleBoxes = visibleBoxes;
     _boxToIndexMap = boxToIndexMap;
+    _peakLiveBoxCount = MAX(_peakLiveBoxCount, visibleBoxes.count);
+
+}
+
+- (NSUInteger)liveBoxCount {
+    return self.visibleBoxes.count;
+}
+
+- (NSUInteger)pooledBoxCount {
+    return self.reusePool.count;
+}
 
+- (void)resetPeakLiveBoxCount {
+    _peakLiveBoxCount = self.liveBoxCount;
+}
+
+- (void)setSessionRecorder:(MGSessionRecorder *)recorder {
+    if (recorder == _sessionRecorder) {
+        return;
+    }
+    [_sessionRecorder stopRecording];
+    _sessionRecorder = recorder;
+    [recorder startRecordingProvider:self];
+}
+
+- (void)recordLayoutTimings:(MGLayoutTimings)timings {
+    _lastLayoutTimings = timings;
 }
 
 - (NSUInteger)count {
@@ -109,41 +558,471 @@
 }
 
 - (UIView <MGLayoutBox> *)boxOfType:(NSString *)type {
-    for (int i = 0; i < _boxCache.count; i++) {
-        UIView <MGLayoutBox> *box = _boxCache[i];
-        if ([box.cacheKey isEqualToString:type]) {
-            [_boxCache removeObject:box];
-            box.alpha = 1;
-            return box;
+    UIView <MGLayoutBox> *box = [self.reusePool dequeueBoxOfType:type];
+    if (box) {
+        box.alpha = 1;
+        [MGAsyncLayoutScheduler.sharedScheduler cancelLayoutFor:box];
+        if ([box respondsToSelector:@selector(cancelAsyncDisplay)]) {
+            [(id)box cancelAsyncDisplay];
         }
+        return box;
     }
-    UIView <MGLayoutBox> *box = self.boxMaker(type);
+    box = self.boxMaker(type);
     box.cacheKey = type;
     return box;
 }
 
+#pragma mark - Batch updates
+
+- (void)performBatchUpdates:(MGBlock)updates completion:(MGBlock)completion {
+    _batchDepth++;
+    if (updates) {
+        updates();
+    }
+    _batchDepth--;
+
+    if (completion) {
+        if (_layoutRequested) {
+            [_requestedCompletions addObject:completion];
+        } else {
+            completion();
+        }
+    }
+    [self runDeferredLayout];
+}
+
+- (BOOL)performingBatchUpdates {
+    return _batchDepth > 0;
+}
+
+- (BOOL)deferLayoutWithDuration:(NSTimeInterval)duration completion:(MGBlock)completion {
+    if (!_batchDepth && !_runningLayoutAnimations && !self.container.layingOut) {
+        return NO;
+    }
+    if (!_layoutRequested) {
+        _layoutRequested = YES;
+        _requestedDuration = 0;
+        _requestedCompletions = NSMutableArray.new;
+    }
+    _requestedDuration = MAX(_requestedDuration, duration);
+    if (completion) {
+        [_requestedCompletions addObject:completion];
+    }
+
+    // requested from inside a layout pass, so run it once that's done
+    if (!_batchDepth && !_runningLayoutAnimations) {
+        [self runDeferredLayoutLater];
+    }
+    return YES;
+}
+
+- (void)runDeferredLayoutLater {
+    if (_deferredLayoutScheduled) {
+        return;
+    }
+    _deferredLayoutScheduled = YES;
+    __weak MGBoxProvider *me = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        MGBoxProvider *provider = me;
+        if (provider) {
+            provider->_deferredLayoutScheduled = NO;
+            [provider runDeferredLayout];
+        }
+    });
+}
+
+- (void)layoutAnimationDidStart {
+    _runningLayoutAnimations++;
+}
+
+- (void)layoutAnimationDidEnd {
+    if (_runningLayoutAnimations) {
+        _runningLayoutAnimations--;
+    }
+    [self runDeferredLayout];
+}
+
+- (void)runDeferredLayout {
+    UIView <MGLayoutBox> *container = self.container;
+    if (!_layoutRequested || _batchDepth || _runningLayoutAnimations) {
+        return;
+    }
+
+    // eg an animation with nothing to animate ends inside its own layout pass
+    if (container.layingOut) {
+        [self runDeferredLayoutLater];
+        return;
+    }
+    NSTimeInterval duration = _requestedDuration;
+    NSArray *completions = _requestedCompletions;
+    _layoutRequested = NO;
+    _requestedDuration = 0;
+    _requestedCompletions = nil;
+
+    MGBlock completion = ^{
+        for (MGBlock block in completions) {
+            block();
+        }
+    };
+    if (duration && [container respondsToSelector:@selector(layoutWithDuration:completion:)]) {
+        [(id)container layoutWithDuration:duration completion:completion];
+    } else {
+        [container layout];
+        completion();
+    }
+}
+
+#pragma mark - Layout cache
+
+- (void)setLayoutCachePath:(NSString *)path {
+    _layoutCachePath = path.copy;
+    [NSNotificationCenter.defaultCenter removeObserver:self
+          name:UIApplicationDidEnterBackgroundNotification object:nil];
+    if (path) {
+        [NSNotificationCenter.defaultCenter addObserver:self
+              selector:@selector(saveLayoutCache)
+              name:UIApplicationDidEnterBackgroundNotification object:nil];
+    }
+}
+
+- (void)saveLayoutCache {
+    NSString *path = self.layoutCachePath;
+    MGBoxFrameIndex *frames = _boxFrames;
+    if (!path || !frames || frames.uniform || self.boxFramesIncomplete
+          || _validatingLayoutCache || frames.count != self.count) {
+        return;
+    }
+    NSArray *keys = self.boxKeyMaker ? _dataKeys.array.copy : nil;
+    if (self.boxIntegerKeyMaker && _integerKeys.count == frames.count) {
+        NSMutableArray *numbers = [NSMutableArray arrayWithCapacity:_integerKeys.count];
+        for (NSUInteger i = 0; i < _integerKeys.count; i++) {
+            [numbers addObject:@([_integerKeys keyAtIndex:i])];
+        }
+        keys = numbers;
+    }
+    CGFloat width = _boxFramesWidth;
+    NSUInteger mode = self.container.contentLayoutMode;
+    CGPoint offset = [self.container isKindOfClass:UIScrollView.class]
+          ? [(UIScrollView *)self.container contentOffset] : CGPointZero;
+
+    // the live frames can change or go away once we're back on main, so the
+    // write gets its own index over a copy of their storage
+    MGBoxFrameIndex *saved = [MGBoxFrameIndex frameIndexWithStorage:frames.storageData
+          offset:0 count:frames.count extent:frames.extent];
+    saved.cursor = frames.cursor;
+    saved.rowBottom = frames.rowBottom;
+
+    // keep running in the background until the file's written
+    UIApplication *app = UIApplication.sharedApplication;
+    __block UIBackgroundTaskIdentifier task = [app beginBackgroundTaskWithExpirationHandler:^{
+        [app endBackgroundTask:task];
+        task = UIBackgroundTaskInvalid;
+    }];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        [MGLayoutCache writeFrames:saved dataKeys:keys containerWidth:width
+              contentMode:mode contentOffset:offset toFile:path];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (task != UIBackgroundTaskInvalid) {
+                [app endBackgroundTask:task];
+                task = UIBackgroundTaskInvalid;
+            }
+        });
+    });
+}
+
+- (void)loadLayoutCache {
+    UIView <MGLayoutBox> *container = self.container;
+    MGLayoutCache *cache = [MGLayoutCache cacheWithContentsOfFile:self.layoutCachePath];
+    if (!cache || cache.count != self.count || cache.containerWidth != container.width
+          || cache.contentMode != container.contentLayoutMode || self.hasUniformBoxes) {
+        return;
+    }
+
+    // trusted like restored nested state, until validation says otherwise
+    MGBoxProviderState *state = MGBoxProviderState.new;
+    state.boxFrames = cache.boxFrames;
+    state.count = cache.count;
+    state.containerWidth = cache.containerWidth;
+    _restoredState = state;
+    _boxFrames = state.boxFrames;
+    _boxFramesWidth = state.containerWidth;
+    _dataKeys = nil;
+    _integerKeys = nil;
+    _dataKeyCount = state.count;
+
+    if ([container isKindOfClass:UIScrollView.class]) {
+        [(UIScrollView *)container setContentOffset:cache.contentOffset];
+    }
+
+    _validatingLayoutCache = cache;
+    _validatedCount = 0;
+    _validatedDataKeys = self.boxKeyMaker
+          ? [NSMutableOrderedSet orderedSetWithCapacity:cache.count] : nil;
+    _validatedIntegerKeys = self.boxIntegerKeyMaker
+          ? [MGIntegerKeyTable tableWithCapacity:cache.count] : nil;
+    _validatedFrames = [MGBoxFrameIndex frameIndexWithCapacity:cache.count];
+    [self validateLayoutCacheLater];
+}
+
+- (void)validateLayoutCacheLater {
+    MGLayoutCache *cache = _validatingLayoutCache;
+    __weak MGBoxProvider *me = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [me validateLayoutCache:cache];
+    });
+}
+
+- (void)validateLayoutCache:(MGLayoutCache *)cache {
+
+    // laid out from live data in the meantime?
+    if (!cache || cache != _validatingLayoutCache) {
+        return;
+    }
+
+    NSArray *cachedKeys = self.boxKeyMaker || self.boxIntegerKeyMaker ? cache.dataKeys : nil;
+    NSUInteger from = _validatedCount;
+    NSUInteger to = MIN(from + LAYOUT_CACHE_VALIDATION_BATCH, cache.count);
+    BOOL valid = self.count == cache.count;
+
+    // frames are restacked from live sizes, margins, and padding, a batch at a
+    // time, and must come out the same as the cached ones
+    if (valid) {
+        [MGLayoutManager stackFramesIn:self.container into:_validatedFrames count:to];
+    }
+    for (NSUInteger i = from; valid && i < to; i++) {
+        if (self.boxIntegerKeyMaker) {
+            uint64_t key = self.boxIntegerKeyMaker(i);
+            valid = [_validatedIntegerKeys addKey:key]
+                  && (!cachedKeys || [cachedKeys[i] isEqual:@(key)]);
+        } else if (self.boxKeyMaker) {
+            id key = self.boxKeyMaker(i);
+            [_validatedDataKeys addObject:key];
+            valid = _validatedDataKeys.count == i + 1
+                  && (!cachedKeys || [cachedKeys[i] isEqual:key]);
+        }
+        valid = valid && CGRectEqualToRect([_validatedFrames frameAtIndex:i],
+              [cache.boxFrames frameAtIndex:i]);
+    }
+
+    if (!valid) {
+        [self discardLayoutCache];
+        return;
+    }
+    _validatedCount = to;
+    if (to < cache.count) {
+        [self validateLayoutCacheLater];
+        return;
+    }
+
+    // all good, so the live keys take over
+    _validatingLayoutCache = nil;
+    if (self.boxKeyMaker) {
+        _dataKeys = _validatedDataKeys;
+        if (!_oldDataKeys && _oldDataKeyCount == _dataKeyCount) {
+            _oldDataKeys = _dataKeys;
+        }
+    } else if (self.boxIntegerKeyMaker) {
+        _integerKeys = _validatedIntegerKeys;
+        if (!_oldIntegerKeys && _oldDataKeyCount == _dataKeyCount) {
+            _oldIntegerKeys = _integerKeys;
+        }
+    }
+    _validatedDataKeys = nil;
+    _validatedIntegerKeys = nil;
+    _validatedFrames = nil;
+}
+
+// the live keys and frames are rebuilt straight away, since the layout may be
+// deferred (eg mid batch), and scroll passes need frames in the meantime
+- (void)discardLayoutCache {
+    _validatingLayoutCache = nil;
+    _validatedDataKeys = nil;
+    _validatedIntegerKeys = nil;
+    _validatedFrames = nil;
+    _restoredState = nil;
+    [self updateDataKeys];
+    [self updateBoxFrames];
+    [self.container layout];
+}
+
+#pragma mark - Nested providers
+
+- (void)prepareNestedScroller:(UIScrollView <MGLayoutBox> *)scroller
+      forIndex:(NSUInteger)index {
+    MGBoxProvider *nested = scroller.boxProvider;
+    NSAssert(nested, @"Nested scrollers must have a boxProvider");
+
+    id key = [self keyForBoxAtIndex:index];
+    id oldKey = [_nestedScrollerKeys objectForKey:scroller];
+    if ([oldKey isEqual:key]) {
+        return;
+    }
+
+    // keep the previous data's state until it comes back on screen
+    if (oldKey) {
+        _nestedStates[oldKey] = nested.nestedState;
+        [MGMemoryBudget.sharedBudget cacheDidGrow:self];
+    }
+    [_nestedScrollerKeys setObject:key forKey:scroller];
+
+    nested.reusePool = self.nestedReusePool;
+    nested.nestedLayoutDeferred = YES;
+
+    MGBoxProviderState *state = _nestedStates[key];
+    [_nestedStates removeObjectForKey:key];
+    [nested restoreNestedState:state];
+    scroller.contentOffset = state ? state.contentOffset : CGPointZero;
+
+    [_pendingNestedScrollers addObject:scroller];
+}
+
+- (void)layoutNestedScrollers {
+    if (!_pendingNestedScrollers.count) {
+        return;
+    }
+    UIView *container = self.container;
+    for (UIScrollView <MGLayoutBox> *scroller in _pendingNestedScrollers.allObjects) {
+
+        // only nested scrollers inside the unbuffered viewport
+        BOOL visible = [scroller isDescendantOfView:container];
+        for (UIView *view = scroller; visible && view != container; view = view.superview) {
+            visible = !view.hidden;
+        }
+        if (!visible || !CGRectIntersectsRect([container convertRect:scroller.bounds
+              fromView:scroller], container.bounds)) {
+            continue;
+        }
+
+        [_pendingNestedScrollers removeObject:scroller];
+        scroller.boxProvider.nestedLayoutDeferred = NO;
+        [scroller layout];
+    }
+}
+
+- (id)nestedState {
+    MGBoxProviderState *state = MGBoxProviderState.new;
+    state.dataKeys = _dataKeys;
+    state.integerKeys = _integerKeys;
+    state.boxFrames = _boxFrames;
+    state.count = _dataKeyCount;
+    state.containerWidth = self.container.width;
+    if ([self.container isKindOfClass:UIScrollView.class]) {
+        state.contentOffset = [(UIScrollView *)self.container contentOffset];
+    }
+    return state;
+}
+
+- (void)restoreNestedState:(MGBoxProviderState *)state {
+
+    // the current boxes belong to the previous data
+    for (UIView <MGLayoutBox> *box in _visibleBoxes.allValues) {
+        box.hidden = YES;
+        [self.reusePool enqueueBox:box];
+    }
+    _visibleBoxes = nil;
+    _visibleIndexes = nil;
+    _boxToIndexMap = nil;
+    _oldBoxToIndexMap = nil;
+    _oldVisibleBoxes = nil;
+    _removedDataKeys = nil;
+
+    _restoredState = state;
+    _dataKeys = _oldDataKeys = state.dataKeys;
+    _integerKeys = _oldIntegerKeys = state.integerKeys;
+    _boxFrames = _oldBoxFrames = state.boxFrames;
+    _boxFramesWidth = state.containerWidth;
+    _dataKeyCount = _oldDataKeyCount = state ? state.count : NSNotFound;
+    _count = _dataKeyCount;
+}
+
 #pragma mark - Individual box state updates
 
 - (id)keyForBoxAtIndex:(NSUInteger)index {
+    if (self.boxIntegerKeyMaker) {
+        return @(self.boxIntegerKeyMaker(index));
+    }
     if (self.boxKeyMaker) {
         return self.boxKeyMaker(index);
     }
     return @(index);
 }
 
+- (NSUInteger)indexOfDataKey:(id)key {
+    if (!key) {
+        return NSNotFound;
+    }
+    if (self.boxIntegerKeyMaker) {
+        return _integerKeys ? [_integerKeys indexOfKey:[key unsignedLongLongValue]] : NSNotFound;
+    }
+    if (!self.boxKeyMaker) {
+        NSUInteger index = [key unsignedIntegerValue];
+        return index < self.count ? index : NSNotFound;
+    }
+    return _dataKeys ? [_dataKeys indexOfObject:key] : NSNotFound;
+}
+
+- (id)displayKeyForBoxAtIndex:(NSUInteger)index {
+
+    // index keys don't identify the data, so can't be trusted for cached bitmaps
+    if ((!self.boxKeyMaker && !self.boxIntegerKeyMaker) || index >= self.count) {
+        return nil;
+    }
+    if (self.boxIntegerKeyMaker) {
+        return _integerKeys.count > index ? @([_integerKeys keyAtIndex:index])
+              : @(self.boxIntegerKeyMaker(index));
+    }
+    return _dataKeys ? _dataKeys[index] : self.boxKeyMaker(index);
+}
+
+#pragma mark - MGTrimmableCache
+
+- (NSString *)cacheName {
+    return @"MGBoxProvider";
+}
+
+// offscreen nested state can be rebuilt by laying out again, so is all that
+// counts against the budget
+- (NSUInteger)cacheCost {
+    NSUInteger cost = 0;
+    for (MGBoxProviderState *state in _nestedStates.allValues) {
+        cost += state.boxFrames.memoryCost + state.dataKeys.count * sizeof(id) * 2
+              + state.integerKeys.memoryCost;
+    }
+    return cost;
+}
+
+- (void)trimToCost:(NSUInteger)cost {
+    if (self.cacheCost > cost) {
+        [_nestedStates removeAllObjects];
+    }
+}
+
+// current frames and keys are needed, so are only reported
+- (NSUInteger)pinnedCost {
+    NSUInteger cost = _boxFrames.memoryCost;
+    if (_oldBoxFrames != _boxFrames) {
+        cost += _oldBoxFrames.memoryCost;
+    }
+    cost += _dataKeys.count * sizeof(id) * 2 + _integerKeys.memoryCost;
+    if (_oldIntegerKeys != _integerKeys) {
+        cost += _oldIntegerKeys.memoryCost;
+    }
+    return cost;
+}
+
 #pragma mark - Animations
 
+// the defaults are called inside the layout pass's animation block, so only
+// need to set the end state. custom blocks are called outside it
 - (void)doAppearAnimationFor:(UIView <MGLayoutBox> *)box atIndex:(NSUInteger)index
       duration:(NSTimeInterval)duration {
     if (self.appearAnimation) {
         self.appearAnimation(box, index, duration, box.frame, box.frame);
     } else {
-        box.alpha = 0;
-        [UIView animateWithDuration:duration delay:0
-              options:UIViewAnimationOptionAllowUserInteraction | UIViewAnimationOptionBeginFromCurrentState
-              animations:^{
-                  box.alpha = 1;
-              } completion:nil];
+        [UIView performWithoutAnimation:^{
+            box.alpha = 0;
+        }];
+        box.alpha = 1;
     }
 }
 
@@ -152,10 +1031,7 @@
     if (self.disappearAnimation) {
         self.disappearAnimation(box, index, duration, box.frame, box.frame);
     } else {
-        [UIView animateWithDuration:duration delay:0
-              options:UIViewAnimationOptionAllowUserInteraction animations:^{
-            box.alpha = 0;
-        } completion:nil];
+        box.alpha = 0;
     }
 }
 
@@ -164,10 +1040,7 @@
     if (self.moveAnimation) {
         self.moveAnimation(box, index, duration, fromFrame, toFrame);
     } else {
-        [UIView animateWithDuration:duration delay:0
-              options:UIViewAnimationOptionAllowUserInteraction animations:^{
-            box.frame = toFrame;
-        } completion:nil];
+        box.frame = toFrame;
     }
 }
 
@@ -175,66 +1048,135 @@
 
 
 - (BOOL)dataAtIndexIsNew:(NSUInteger)index {
-    return ![_oldDataKeys containsObject:_dataKeys[index]];
+    return ![self dataAtIndexIsExisting:index];
 }
 
+// data appended by layoutAppendedBoxes is in the old keys too, so counts as
+// existing and appears without animation
 - (BOOL)dataAtIndexIsExisting:(NSUInteger)index {
+    if (_integerKeys) {
+        return [_oldIntegerKeys containsKey:[_integerKeys keyAtIndex:index]];
+    }
+    if (!_dataKeys) {
+        return _oldDataKeyCount != NSNotFound && index < _oldDataKeyCount;
+    }
     return [_oldDataKeys containsObject:_dataKeys[index]];
 }
 
 - (BOOL)dataAtOldIndexIsOld:(NSUInteger)index {
+    if (_integerKeys) {
+        return index >= _oldIntegerKeys.count
+              || ![_integerKeys containsKey:[_oldIntegerKeys keyAtIndex:index]];
+    }
+    if (!_dataKeys) {
+        return index >= _dataKeyCount;
+    }
     return ![_dataKeys containsObject:_oldDataKeys[index]];
 }
 
 - (NSUInteger)oldIndexOfDataAtIndex:(NSUInteger)index {
+    if (_integerKeys) {
+        return _oldIntegerKeys ? [_oldIntegerKeys indexOfKey:[_integerKeys keyAtIndex:index]]
+              : NSNotFound;
+    }
+    if (!_dataKeys) {
+        return [self dataAtIndexIsExisting:index] ? index : NSNotFound;
+    }
     return _oldDataKeys ? [_oldDataKeys indexOfObject:_dataKeys[index]] : NSNotFound;
 }
 
 - (BOOL)dataWasRemovedForBox:(UIView <MGLayoutBox> *)box {
     NSUInteger index = [self oldIndexOfBox:box];
-    if (index == NSNotFound || index >= _oldDataKeys.count) {
+    if (index == NSNotFound || _oldDataKeyCount == NSNotFound || index >= _oldDataKeyCount) {
         return NO;
     }
+    if (_integerKeys) {
+        return _oldIntegerKeys && index < _oldIntegerKeys.count
+              && ![_integerKeys containsKey:[_oldIntegerKeys keyAtIndex:index]];
+    }
+    if (!_dataKeys) {
+        return index >= _dataKeyCount;
+    }
     return _removedDataKeys ? [_removedDataKeys containsObject:_oldDataKeys[index]] : NO;
 }
 
 - (NSUInteger)indexOfBox:(UIView <MGLayoutBox> *)box {
-    id value = [_boxToIndexMap objectForKey:box];
-    if (!value) {
-        return NSNotFound;
-    }
-    return [value unsignedIntegerValue];
+    return _boxToIndexMap ? [_boxToIndexMap indexOfKey:MGPointerKey(box)] : NSNotFound;
 }
 
 - (NSUInteger)oldIndexOfBox:(UIView <MGLayoutBox> *)box {
-    id value = [_oldBoxToIndexMap objectForKey:box];
-    if (!value) {
-        return NSNotFound;
+    return _oldBoxToIndexMap ? [_oldBoxToIndexMap indexOfKey:MGPointerKey(box)] : NSNotFound;
+}
+
+#pragma mark - Getters
+
+- (MGBoxReusePool *)reusePool {
+    if (!_reusePool) {
+        _reusePool = MGBoxReusePool.pool;
     }
-    return [value unsignedIntegerValue];
+    return _reusePool;
+}
+
+- (MGBoxReusePool *)nestedReusePool {
+    if (!_nestedReusePool) {
+        _nestedReusePool = MGBoxReusePool.pool;
+    }
+    return _nestedReusePool;
 }
 
 #pragma mark - Frames
 
+// grids have computed frames too, so take the same paths as uniform boxes
+- (BOOL)hasUniformBoxes {
+    return !CGSizeEqualToSize(self.uniformBoxSize, CGSizeZero) || self.hasGridBoxes;
+}
+
+- (BOOL)hasGridBoxes {
+    return self.rowHeightMaker || self.columnWidthMaker;
+}
+
 - (CGSize)sizeForBoxAtIndex:(NSUInteger)index {
+    if (self.hasGridBoxes) {
+        return [_boxFrames frameAtIndex:index].size;
+    }
+    if (self.hasUniformBoxes) {
+        return self.uniformBoxSize;
+    }
     return self.boxSizeMaker(index);
 }
 
 - (UIEdgeInsets)marginForBoxAtIndex:(NSUInteger)index {
+    if (self.hasUniformBoxes) {
+        return self.uniformBoxMargin;
+    }
     return self.boxMarginMaker ? self.boxMarginMaker(index) : UIEdgeInsetsZero;
 }
 
+- (MGBoxFrameIndex *)boxFrames {
+    return _boxFrames;
+}
+
+// while frames are still being stacked, the unstacked rest is assumed to be
+// the same average height as the stacked part
+- (CGSize)estimatedBoxFramesExtent {
+    CGSize extent = _boxFrames.extent;
+    if (self.boxFramesIncomplete && _boxFrames.count) {
+        CGFloat top = self.container.topPadding;
+        extent.height = top + (extent.height - top) * self.count / _boxFrames.count;
+    }
+    return extent;
+}
+
 - (CGRect)frameForBoxAtIndex:(NSUInteger)index {
-    return [_boxFrames[index] CGRectValue];
+    return [_boxFrames frameAtIndex:index];
 }
 
 - (CGRect)oldFrameForBoxAtIndex:(NSUInteger)index {
-    if (index >= _oldBoxFrames.count) {
+    NSUInteger oldIndex = [self oldIndexOfDataAtIndex:index];
+    if (oldIndex == NSNotFound) {
         return CGRectZero;
     }
-    id dataKey = _dataKeys[index];
-    NSUInteger oldIndex = [_oldDataKeys indexOfObject:dataKey];
-    return [_oldBoxFrames[oldIndex] CGRectValue];
+    return [_oldBoxFrames frameAtIndex:oldIndex];
 }
 
 @end
@@ -0,0 +1,64 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+#import "MGMemoryBudget.h"
+
+@protocol MGLayoutBox;
+
+/**
+A pool of offscreen boxes waiting to be reused, grouped by box type (the box's
+[cacheKey](-[MGLayoutBox cacheKey])).
+
+Every <MGBoxProvider> has its own pool by default. Nested providers (eg
+horizontal carousels inside the rows of a vertical table) can share a single
+pool, so that a box scrolled out of one carousel can be reused by another.
+
+    MGBoxReusePool *pool = MGBoxReusePool.pool;
+    for (MGBoxProvider *carouselProvider in carouselProviders) {
+        carouselProvider.reusePool = pool;
+    }
+
+Pools are registered with the <MGMemoryBudget>, which drops the longest pooled
+boxes first when trimming.
+*/
+
+@interface MGBoxReusePool : NSObject <MGTrimmableCache>
+
+/**
+* Returns a new, empty reuse pool.
+*/
++ (instancetype)pool;
+
+/**
+* Removes and returns a pooled box of the given type, or `nil` if there are none.
+*/
+- (UIView <MGLayoutBox> *)dequeueBoxOfType:(NSString *)type;
+
+/**
+* Adds a box to the pool. Boxes without a `cacheKey` are ignored.
+*/
+- (void)enqueueBox:(UIView <MGLayoutBox> *)box;
+
+/**
+* Empties the pool.
+*/
+- (void)removeAllBoxes;
+
+/**
+* The total number of pooled boxes, of all types.
+*/
+@property (nonatomic, readonly) NSUInteger count;
+
+/** @name Stats */
+
+/**
+* The fraction of dequeues that found a pooled box, for each box type, as
+* `NSNumber`s from 0 to 1, since the pool was made or <resetStats> was called.
+*/
+- (NSDictionary *)hitRates;
+
+- (void)resetStats;
+
+@end
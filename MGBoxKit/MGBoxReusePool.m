@@ -0,0 +1,137 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBoxReusePool.h"
+#import "MGLayoutBox.h"
+
+@implementation MGBoxReusePool {
+    NSMutableDictionary *_boxesByType;
+    NSMutableOrderedSet *_boxesByAge;
+    NSUInteger _count, _cost;
+    NSMapTable *_costs;
+    NSCountedSet *_hits, *_misses;
+}
+
++ (instancetype)pool {
+    return [[self alloc] init];
+}
+
+- (id)init {
+    self = [super init];
+    _boxesByType = NSMutableDictionary.new;
+    _boxesByAge = NSMutableOrderedSet.new;
+    _costs = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+          valueOptions:NSPointerFunctionsStrongMemory];
+    _hits = NSCountedSet.new;
+    _misses = NSCountedSet.new;
+    [MGMemoryBudget.sharedBudget registerCache:self];
+    return self;
+}
+
+- (UIView <MGLayoutBox> *)dequeueBoxOfType:(NSString *)type {
+    NSMutableOrderedSet *boxes = _boxesByType[type];
+    UIView <MGLayoutBox> *box = boxes.lastObject;
+    if (box) {
+        [boxes removeObjectAtIndex:boxes.count - 1];
+        [_boxesByAge removeObject:box];
+        [self forgetCostOf:box];
+        _count--;
+    }
+    if (type) {
+        [box ? _hits : _misses addObject:type];
+    }
+    return box;
+}
+
+- (void)enqueueBox:(UIView <MGLayoutBox> *)box {
+    if (!box.cacheKey) {
+        return;
+    }
+    NSMutableOrderedSet *boxes = _boxesByType[box.cacheKey];
+    if (!boxes) {
+        boxes = NSMutableOrderedSet.orderedSet;
+        _boxesByType[box.cacheKey] = boxes;
+    }
+    if (![boxes containsObject:box]) {
+        [boxes addObject:box];
+        [_boxesByAge addObject:box];
+        _count++;
+
+        // costed once here, since walking every pooled subtree per check adds up
+        NSUInteger cost = MGEstimatedCostOfView(box);
+        [_costs setObject:@(cost) forKey:box];
+        _cost += cost;
+        [MGMemoryBudget.sharedBudget cacheDidGrow:self];
+    }
+}
+
+- (void)removeAllBoxes {
+    NSAssert(NSThread.isMainThread, @"Pooled boxes must be removed on the main thread");
+    for (UIView *box in _boxesByAge) {
+        [box removeFromSuperview];
+    }
+    [_boxesByType removeAllObjects];
+    [_boxesByAge removeAllObjects];
+    [_costs removeAllObjects];
+    _count = 0;
+    _cost = 0;
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (void)forgetCostOf:(UIView *)box {
+    _cost -= MIN(_cost, [[_costs objectForKey:box] unsignedIntegerValue]);
+    [_costs removeObjectForKey:box];
+}
+
+#pragma mark - Stats
+
+- (NSDictionary *)hitRates {
+    NSMutableSet *types = [NSMutableSet setWithSet:_hits];
+    [types unionSet:_misses];
+    NSMutableDictionary *rates = NSMutableDictionary.new;
+    for (NSString *type in types) {
+        NSUInteger hits = [_hits countForObject:type];
+        NSUInteger misses = [_misses countForObject:type];
+        rates[type] = @((double)hits / (hits + misses));
+    }
+    return rates;
+}
+
+- (void)resetStats {
+    [_hits removeAllObjects];
+    [_misses removeAllObjects];
+}
+
+#pragma mark - MGTrimmableCache
+
+- (NSString *)cacheName {
+    return @"MGBoxReusePool";
+}
+
+- (NSUInteger)cacheCost {
+    return _cost;
+}
+
+- (void)trimToCost:(NSUInteger)cost {
+    if (!cost) {
+        [self removeAllBoxes];
+        return;
+    }
+    NSAssert(NSThread.isMainThread, @"Pooled boxes must be removed on the main thread");
+    while (_cost > cost && _boxesByAge.count) {
+        UIView <MGLayoutBox> *box = _boxesByAge.firstObject;
+        [_boxesByAge removeObjectAtIndex:0];
+        [_boxesByType[box.cacheKey] removeObject:box];
+        [self forgetCostOf:box];
+        _count--;
+
+        // pooled boxes are still in their container, which would otherwise keep them
+        [box removeFromSuperview];
+    }
+}
+
+@end
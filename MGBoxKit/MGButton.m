@@ -6,10 +6,10 @@
 
 #import "MGButton.h"
 #import "MGLayoutManager.h"
+#import "MGAsyncLayoutScheduler.h"
 
 @implementation MGButton {
   BOOL fixedPositionEstablished;
-  BOOL asyncDrawing, asyncDrawOnceing;
 }
 
 // MGLayoutBox protocol
@@ -40,21 +40,7 @@
   [MGLayoutManager layoutBoxesIn:self];
 
   // async draws
-  if (self.asyncLayout || self.asyncLayoutOnce) {
-    dispatch_async(self.asyncQueue, ^{
-        if (self.asyncLayout && !self->asyncDrawing) {
-            self->asyncDrawing = YES;
-            self.asyncLayout();
-            self->asyncDrawing = NO;
-        }
-        if (self.asyncLayoutOnce && !self->asyncDrawOnceing) {
-            self->asyncDrawOnceing = YES;
-            self.asyncLayoutOnce();
-            self.asyncLayoutOnce = nil;
-            self->asyncDrawOnceing = NO;
-      }
-    });
-  }
+  [MGAsyncLayoutScheduler.sharedScheduler scheduleLayoutFor:self];
 }
 
 #pragma mark - Getters
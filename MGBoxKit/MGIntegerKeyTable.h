@@ -0,0 +1,55 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+/**
+* A flat open addressing hash table from 64 bit keys to indexes, with no
+* Objective-C objects per entry. Used for integer data keys (see
+* [boxIntegerKeyMaker](-[MGBoxProvider boxIntegerKeyMaker])) and for mapping
+* box pointers to their indexes.
+*
+* Keys added with <addKey:> are also kept in order, so the table doubles as
+* the list of keys by index. Keys mapped with <setIndex:forKey:> aren't kept
+* in order, so <keyAtIndex:> isn't meaningful for those tables.
+*/
+
+@interface MGIntegerKeyTable : NSObject
+
++ (instancetype)tableWithCapacity:(NSUInteger)capacity;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+* Adds the key at the next index (ie at <count>). Returns NO, and adds nothing,
+* if the key is already in the table.
+*/
+- (BOOL)addKey:(uint64_t)key;
+
+/**
+* Maps the key to an arbitrary index, replacing any previous mapping.
+*/
+- (void)setIndex:(NSUInteger)index forKey:(uint64_t)key;
+
+- (uint64_t)keyAtIndex:(NSUInteger)index;
+
+/**
+* The index of the key, or `NSNotFound`. `O(1)` on average.
+*/
+- (NSUInteger)indexOfKey:(uint64_t)key;
+- (BOOL)containsKey:(uint64_t)key;
+
+/**
+* The approximate number of bytes used by the table's storage.
+*/
+@property (nonatomic, readonly) NSUInteger memoryCost;
+
+@end
+
+/**
+* A table key for an object's pointer.
+*/
+static inline uint64_t MGPointerKey(id object) {
+    return (uint64_t)(uintptr_t)(__bridge void *)object;
+}
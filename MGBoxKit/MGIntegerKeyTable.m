@@ -0,0 +1,139 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGIntegerKeyTable.h"
+
+// slots are kept at most half full, so probe runs stay short
+#define MAX_LOAD_FACTOR 0.5
+
+// splitmix64 finaliser. row ids and pointers are far from random in their
+// low bits, which are the bits used for the slot
+static inline uint64_t MGHashKey(uint64_t key) {
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+@implementation MGIntegerKeyTable {
+    uint64_t *_keys;
+    NSUInteger _keysCapacity;
+
+    // slot tables. an empty slot has an index of NSNotFound
+    uint64_t *_slotKeys;
+    NSUInteger *_slotIndexes;
+    NSUInteger _slotCount;
+}
+
++ (instancetype)tableWithCapacity:(NSUInteger)capacity {
+    MGIntegerKeyTable *table = [[self alloc] init];
+    [table reserveSlots:MAX(capacity * 2, 8)];
+    return table;
+}
+
+#pragma mark - Adding
+
+- (BOOL)addKey:(uint64_t)key {
+    NSUInteger slot = [self slotForKey:key];
+    if (_slotIndexes[slot] != NSNotFound) {
+        return NO;
+    }
+    if (_count == _keysCapacity) {
+        _keysCapacity = MAX(_keysCapacity * 2, 16);
+        _keys = realloc(_keys, _keysCapacity * sizeof(uint64_t));
+    }
+    _keys[_count] = key;
+    [self fillSlot:slot key:key index:_count];
+    return YES;
+}
+
+- (void)setIndex:(NSUInteger)index forKey:(uint64_t)key {
+    NSUInteger slot = [self slotForKey:key];
+    if (_slotIndexes[slot] != NSNotFound) {
+        _slotIndexes[slot] = index;
+        return;
+    }
+    [self fillSlot:slot key:key index:index];
+}
+
+- (void)fillSlot:(NSUInteger)slot key:(uint64_t)key index:(NSUInteger)index {
+    _slotKeys[slot] = key;
+    _slotIndexes[slot] = index;
+    _count++;
+    if (_count > _slotCount * MAX_LOAD_FACTOR) {
+        [self reserveSlots:_slotCount * 2];
+    }
+}
+
+#pragma mark - Lookups
+
+- (uint64_t)keyAtIndex:(NSUInteger)index {
+    NSAssert(index < _count && _keys, @"Key index %d out of range", (int)index);
+    return _keys[index];
+}
+
+- (NSUInteger)indexOfKey:(uint64_t)key {
+    return _slotIndexes[[self slotForKey:key]];
+}
+
+- (BOOL)containsKey:(uint64_t)key {
+    return [self indexOfKey:key] != NSNotFound;
+}
+
+- (NSUInteger)memoryCost {
+    return _keysCapacity * sizeof(uint64_t)
+          + _slotCount * (sizeof(uint64_t) + sizeof(NSUInteger));
+}
+
+#pragma mark - Slots
+
+// the key's slot, or the empty slot where it would go. linear probing
+- (NSUInteger)slotForKey:(uint64_t)key {
+    NSUInteger mask = _slotCount - 1;
+    NSUInteger slot = (NSUInteger)MGHashKey(key) & mask;
+    while (_slotIndexes[slot] != NSNotFound && _slotKeys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+- (void)reserveSlots:(NSUInteger)minimum {
+    NSUInteger slotCount = 8;
+    while (slotCount < minimum || _count > slotCount * MAX_LOAD_FACTOR) {
+        slotCount *= 2;
+    }
+    if (slotCount <= _slotCount) {
+        return;
+    }
+
+    uint64_t *oldKeys = _slotKeys;
+    NSUInteger *oldIndexes = _slotIndexes, oldCount = _slotCount;
+
+    _slotCount = slotCount;
+    _slotKeys = malloc(slotCount * sizeof(uint64_t));
+    _slotIndexes = malloc(slotCount * sizeof(NSUInteger));
+    for (NSUInteger i = 0; i < slotCount; i++) {
+        _slotIndexes[i] = NSNotFound;
+    }
+
+    // rehash
+    for (NSUInteger i = 0; i < oldCount; i++) {
+        if (oldIndexes[i] != NSNotFound) {
+            NSUInteger slot = [self slotForKey:oldKeys[i]];
+            _slotKeys[slot] = oldKeys[i];
+            _slotIndexes[slot] = oldIndexes[i];
+        }
+    }
+    free(oldKeys);
+    free(oldIndexes);
+}
+
+#pragma mark - Fini
+
+- (void)dealloc {
+    free(_keys);
+    free(_slotKeys);
+    free(_slotIndexes);
+}
+
+@end
@@ -18,7 +18,7 @@ typedef enum {
 } MGBoxResizingMode;
 
 typedef enum {
-  MGLayoutTableStyle, MGLayoutGridStyle
+  MGLayoutTableStyle, MGLayoutGridStyle, MGLayoutMasonryStyle
 } MGContentLayoutMode;
 
 /**
@@ -73,6 +73,10 @@ call to [layout](-[MGLayoutBox layout]) or [layoutWithDuration:completion:](-[MG
 after the standard layout pass has completed. Useful for performing any CPU or
 network intensive data gathering that will result in presentation changes.
 
+Runs are scheduled by <MGAsyncLayoutScheduler>, so repeated layouts before the
+block runs only run it once, on screen boxes run first, and pending runs are
+dropped when the box is reused by a box provider.
+
     box.asyncLayout = ^{
 
         // fetch a remote image on a background thread
@@ -230,6 +234,9 @@ box with another.
 * Define whether child boxes will be laid out in a table list or in a grid.
 * - `MGLayoutTableStyle` for a table layout, similar to `UITableView`
 * - `MGLayoutGridStyle` for a grid layout, similar to `UICollectionView`.
+* - `MGLayoutMasonryStyle` for a column based "waterfall" layout, with each box
+*   placed in the currently shortest column. See
+*   [columnCount](-[MGBoxProvider columnCount]).
 * Default is `MGLayoutTableStyle`.
 */
 @property (nonatomic, assign) MGContentLayoutMode contentLayoutMode;
@@ -0,0 +1,52 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+@class MGBoxFrameIndex;
+
+/**
+* A box provider's data keys and frames, saved to a compact binary file so that
+* the next launch can show the remembered viewport without asking for every
+* item's key, size, and margin first. Used by
+* [layoutCachePath](-[MGBoxProvider layoutCachePath]).
+*
+* The file is memory mapped when read, and the frames are used in place, so
+* loading costs the same whatever the item count. The data keys are only
+* decoded when <dataKeys> is first asked for.
+*/
+
+@interface MGLayoutCache : NSObject
+
+/**
+* Maps the file at the given path. Returns `nil` if there's no file, or it was
+* written by a different format version or architecture.
+*/
++ (instancetype)cacheWithContentsOfFile:(NSString *)path;
+
+/**
+* Writes the frames, data keys, and scroll offset to the given path. Keys that
+* don't conform to `NSCoding` are left out, in which case only the frames can
+* be validated on the next load. Returns NO if the file couldn't be written.
+*/
++ (BOOL)writeFrames:(MGBoxFrameIndex *)frames dataKeys:(NSArray *)keys
+      containerWidth:(CGFloat)width contentMode:(NSUInteger)mode
+      contentOffset:(CGPoint)offset toFile:(NSString *)path;
+
+@property (nonatomic, readonly) NSUInteger count;
+@property (nonatomic, readonly) CGFloat containerWidth;
+@property (nonatomic, readonly) NSUInteger contentMode;
+@property (nonatomic, readonly) CGPoint contentOffset;
+
+/**
+* The saved frames, backed by the mapped file until they're appended to.
+*/
+@property (nonatomic, readonly) MGBoxFrameIndex *boxFrames;
+
+/**
+* The saved data keys, or `nil` if they weren't saved.
+*/
+@property (nonatomic, readonly) NSArray *dataKeys;
+
+@end
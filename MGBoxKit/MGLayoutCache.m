@@ -0,0 +1,144 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGLayoutCache.h"
+#import "MGBoxFrameIndex.h"
+
+#define MG_LAYOUT_CACHE_MAGIC 0x434c474d // "MGLC"
+#define MG_LAYOUT_CACHE_VERSION 1
+
+// fixed size header at the start of the file. frame storage follows at
+// MG_LAYOUT_CACHE_FRAMES_OFFSET, then the archived data keys
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t floatSize;
+    uint32_t contentMode;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t framesLength;
+    uint64_t keysLength;
+    double containerWidth;
+    double offsetX, offsetY;
+    double extentWidth, extentHeight;
+    double cursorX, cursorY, rowBottom;
+} MGLayoutCacheHeader;
+
+#define MG_LAYOUT_CACHE_FRAMES_OFFSET 128
+
+@implementation MGLayoutCache {
+    NSData *_data;
+    NSRange _keysRange;
+    BOOL _keysDecoded;
+}
+
+@synthesize dataKeys = _dataKeys;
+
++ (instancetype)cacheWithContentsOfFile:(NSString *)path {
+    if (!path) {
+        return nil;
+    }
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways
+          error:nil];
+    if (data.length < MG_LAYOUT_CACHE_FRAMES_OFFSET) {
+        return nil;
+    }
+
+    MGLayoutCacheHeader header;
+    [data getBytes:&header length:sizeof(header)];
+    if (header.magic != MG_LAYOUT_CACHE_MAGIC || header.version != MG_LAYOUT_CACHE_VERSION
+          || header.floatSize != sizeof(CGFloat)) {
+        return nil;
+    }
+    uint64_t framesEnd = MG_LAYOUT_CACHE_FRAMES_OFFSET + header.framesLength;
+    if (header.framesLength != [MGBoxFrameIndex storageLengthForCount:(NSUInteger)header.count]
+          || framesEnd + header.keysLength > data.length) {
+        return nil;
+    }
+
+    MGLayoutCache *cache = [[self alloc] init];
+    cache->_data = data;
+    cache->_count = (NSUInteger)header.count;
+    cache->_containerWidth = header.containerWidth;
+    cache->_contentMode = header.contentMode;
+    cache->_contentOffset = (CGPoint){header.offsetX, header.offsetY};
+    cache->_keysRange = NSMakeRange((NSUInteger)framesEnd, (NSUInteger)header.keysLength);
+
+    MGBoxFrameIndex *frames = [MGBoxFrameIndex frameIndexWithStorage:data
+          offset:MG_LAYOUT_CACHE_FRAMES_OFFSET count:cache->_count
+          extent:(CGSize){header.extentWidth, header.extentHeight}];
+    frames.cursor = (CGPoint){header.cursorX, header.cursorY};
+    frames.rowBottom = header.rowBottom;
+    cache->_boxFrames = frames;
+
+    return cache;
+}
+
++ (BOOL)writeFrames:(MGBoxFrameIndex *)frames dataKeys:(NSArray *)keys
+      containerWidth:(CGFloat)width contentMode:(NSUInteger)mode
+      contentOffset:(CGPoint)offset toFile:(NSString *)path {
+    if (!frames || frames.uniform || !path) {
+        return NO;
+    }
+
+    // only keep keys that can be archived
+    NSData *archivedKeys = nil;
+    if (keys.count == frames.count) {
+        BOOL codable = YES;
+        for (id key in keys) {
+            if (![key conformsToProtocol:@protocol(NSCoding)]) {
+                codable = NO;
+                break;
+            }
+        }
+        if (codable) {
+            archivedKeys = [NSKeyedArchiver archivedDataWithRootObject:keys];
+        }
+    }
+
+    NSData *storage = frames.storageData;
+    MGLayoutCacheHeader header = {
+        .magic = MG_LAYOUT_CACHE_MAGIC,
+        .version = MG_LAYOUT_CACHE_VERSION,
+        .floatSize = sizeof(CGFloat),
+        .contentMode = (uint32_t)mode,
+        .count = frames.count,
+        .framesLength = storage.length,
+        .keysLength = archivedKeys.length,
+        .containerWidth = width,
+        .offsetX = offset.x,
+        .offsetY = offset.y,
+        .extentWidth = frames.extent.width,
+        .extentHeight = frames.extent.height,
+        .cursorX = frames.cursor.x,
+        .cursorY = frames.cursor.y,
+        .rowBottom = frames.rowBottom
+    };
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:MG_LAYOUT_CACHE_FRAMES_OFFSET
+          + storage.length + archivedKeys.length];
+    [data appendBytes:&header length:sizeof(header)];
+    data.length = MG_LAYOUT_CACHE_FRAMES_OFFSET;
+    [data appendData:storage];
+    if (archivedKeys) {
+        [data appendData:archivedKeys];
+    }
+    return [data writeToFile:path atomically:YES];
+}
+
+- (NSArray *)dataKeys {
+    if (!_keysDecoded) {
+        _keysDecoded = YES;
+        if (_keysRange.length) {
+            NSData *archived = [_data subdataWithRange:_keysRange];
+            id keys = [NSKeyedUnarchiver unarchiveObjectWithData:archived];
+            if ([keys isKindOfClass:NSArray.class] && [keys count] == _count) {
+                _dataKeys = keys;
+            }
+        }
+    }
+    return _dataKeys;
+}
+
+@end
@@ -4,14 +4,23 @@
 
 #import "MGLayoutBox.h"
 
+@class MGBoxFrameIndex;
+
+CGFloat roundToPixel(CGFloat value);
+
 @interface MGLayoutManager : NSObject
 
 + (void)layoutBoxesIn:(UIView <MGLayoutBox> *)container;
 + (void)layoutBoxesIn:(UIView <MGLayoutBox> *)container duration:(NSTimeInterval)duration
       completion:(MGBlock)completion;
++ (void)layoutAppendedBoxesIn:(UIView <MGLayoutBox> *)container;
++ (void)layoutScrolledBoxesIn:(UIView <MGLayoutBox> *)container;
 + (void)layoutVisibleBoxesIn:(UIView <MGLayoutBox> *)container
       duration:(NSTimeInterval)duration completion:(MGBlock)completion;
-+ (NSOrderedSet *)framesForBoxesIn:(UIView <MGLayoutBox> *)container;
++ (MGBoxFrameIndex *)framesForBoxesIn:(UIView <MGLayoutBox> *)container;
++ (void)stackFramesIn:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames;
++ (void)stackFramesIn:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames
+      count:(NSUInteger)count;
 + (void)positionBoxesIn:(UIView <MGLayoutBox> *)container;
 + (void)positionAttachedBoxesIn:(UIView <MGLayoutBox> *)container;
 + (NSArray *)findBoxesInView:(UIView *)view notInSet:(id)boxes;
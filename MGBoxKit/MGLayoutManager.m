@@ -4,17 +4,38 @@
 
 #import "MGLayoutManager.h"
 #import "MGScrollView.h"
+#import "MGBox.h"
 #import "MGBoxProvider.h"
+#import "MGBoxFrameIndex.h"
+#import "MGSessionRecorder.h"
 #import <tgmath.h>
 
 CGFloat roundToPixel(CGFloat value) {
   return UIScreen.mainScreen.scale == 1 ? round(value) : round(value * 2.0) / 2.0;
 }
 
+// seconds since the mark, moving the mark up to now
+static inline NSTimeInterval MGLapTime(CFTimeInterval *mark) {
+  CFTimeInterval now = CACurrentMediaTime();
+  NSTimeInterval lap = now - *mark;
+  *mark = now;
+  return lap;
+}
+
 @implementation MGLayoutManager
 
 + (void)layoutBoxesIn:(UIView <MGLayoutBox> *)container {
 
+  // nested scroller waiting to come on screen?
+  if (container.boxProvider.nestedLayoutDeferred) {
+    return;
+  }
+
+  // batching, mid animation, or mid layout? then coalesce into a later layout
+  if ([container.boxProvider deferLayoutWithDuration:0 completion:nil]) {
+    return;
+  }
+
   // layout locked?
   if (container.layingOut) {
     return;
@@ -23,13 +44,23 @@ CGFloat roundToPixel(CGFloat value) {
 
     // box provider style layout
     if (container.boxProvider) {
+        MGLayoutTimings timings = {0};
+        CFTimeInterval start = CACurrentMediaTime(), mark = start;
         [container.boxProvider updateDataKeys];
+        timings.dataKeys = MGLapTime(&mark);
         [container.boxProvider updateBoxFrames];
+        timings.boxFrames = MGLapTime(&mark);
         [container.boxProvider updateVisibleIndexes];
+        timings.visibleIndexes = MGLapTime(&mark);
         [self layoutVisibleBoxesIn:container duration:0 completion:nil];
+        timings.boxes = MGLapTime(&mark);
         [self updateContentSizeFor:container];
         [container.boxProvider updateOldDataKeys];
         [container.boxProvider updateOldBoxFrames];
+        timings.total = CACurrentMediaTime() - start;
+        [container.boxProvider recordLayoutTimings:timings];
+        [container.boxProvider.sessionRecorder recordLayout:MGTraceFullLayout
+              duration:timings.total];
         container.layingOut = NO;
         return;
     }
@@ -60,12 +91,56 @@ CGFloat roundToPixel(CGFloat value) {
   container.layingOut = NO;
 }
 
++ (void)layoutAppendedBoxesIn:(UIView <MGLayoutBox> *)container {
+    if (container.boxProvider.nestedLayoutDeferred) {
+        return;
+    }
+
+    // batching, mid animation, or mid layout? then the appended items go in a
+    // coalesced full layout later
+    if ([container.boxProvider deferLayoutWithDuration:0 completion:nil]) {
+        return;
+    }
+    container.layingOut = YES;
+
+    // only the appended items get keys and frames
+    MGBoxProvider *provider = container.boxProvider;
+    MGLayoutTimings timings = {0};
+    CFTimeInterval start = CACurrentMediaTime(), mark = start;
+    [provider updateAppendedDataKeys];
+    timings.dataKeys = MGLapTime(&mark);
+    [provider updateAppendedBoxFrames];
+    timings.boxFrames = MGLapTime(&mark);
+    [provider updateVisibleIndexes];
+    timings.visibleIndexes = MGLapTime(&mark);
+    [self layoutVisibleBoxesIn:container duration:0 completion:nil];
+    timings.boxes = MGLapTime(&mark);
+    [self updateContentSizeFor:container];
+    [provider updateOldDataKeys];
+    [provider updateOldBoxFrames];
+    timings.total = CACurrentMediaTime() - start;
+    [provider recordLayoutTimings:timings];
+    [provider.sessionRecorder recordLayout:MGTraceAppendedLayout duration:timings.total];
+    container.layingOut = NO;
+}
+
++ (void)layoutScrolledBoxesIn:(UIView <MGLayoutBox> *)container {
+    MGBoxProvider *provider = container.boxProvider;
+    MGLayoutTimings timings = {0};
+    CFTimeInterval start = CACurrentMediaTime(), mark = start;
+    [provider updateVisibleIndexes];
+    timings.visibleIndexes = MGLapTime(&mark);
+    [self layoutVisibleBoxesIn:container duration:0 completion:nil];
+    timings.boxes = MGLapTime(&mark);
+    timings.total = timings.visibleIndexes + timings.boxes;
+    [provider recordLayoutTimings:timings];
+    [provider.sessionRecorder recordLayout:MGTraceScrolledLayout duration:timings.total];
+}
+
 + (void)layoutVisibleBoxesIn:(UIView <MGLayoutBox> *)container
       duration:(NSTimeInterval)duration completion:(MGBlock)completion {
     MGBoxProvider *provider = container.boxProvider;
 
-    NSMapTable *boxToIndexMap = [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality
-                                                      valueOptions:NSMapTableStrongMemory];
     NSMutableDictionary *visibleBoxes = NSMutableDictionary.new;
 
     NSMutableOrderedSet *appearingBoxes = NSMutableOrderedSet.new;
@@ -84,6 +159,9 @@ CGFloat roundToPixel(CGFloat value) {
         }
         if (!box) {
             box = provider.boxCustomiser(index);
+            if ([box respondsToSelector:@selector(setAsyncDisplayKey:)]) {
+                [(id)box setAsyncDisplayKey:[provider displayKeyForBoxAtIndex:index]];
+            }
             [box layout];
             if (!newData) {
                 CGRect oldFrame = [provider oldFrameForBoxAtIndex:index];
@@ -133,18 +211,16 @@ CGFloat roundToPixel(CGFloat value) {
         if (box.alpha != 1) {
             box.alpha = 1;
         }
-        [boxToIndexMap setObject:@(index) forKey:box];
     }];
 
-    [provider updateVisibleBoxes:visibleBoxes
-                   boxToIndexMap:boxToIndexMap];
+    [provider updateVisibleBoxes:visibleBoxes];
 
     // collate boxes that have scrolled offscreen
     for (UIView <MGLayoutBox> *box in container.subviews) {
         if (![box conformsToProtocol:@protocol(MGLayoutBox)]) {
             continue;
         }
-        if (![visibleBoxes.allValues containsObject:box]) {
+        if ([provider indexOfBox:box] == NSNotFound) {
             // box must have scrolled off-screen
             if ([provider dataWasRemovedForBox:box]) {
                 // data has disappeared, animate out
@@ -163,34 +239,142 @@ CGFloat roundToPixel(CGFloat value) {
     // zIndex stacking
     [MGLayoutManager stackByZIndexIn:container];
 
-    // do disappear animations
+    // boxes that start and end outside the viewport snap instead of animating
+    CGRect viewport = container.bounds;
+    NSMutableSet *animatedDisappears = NSMutableSet.new;
+    NSMutableSet *animatedAppears = NSMutableSet.new;
+    NSMutableSet *animatedMoves = NSMutableSet.new;
     if (duration) {
         for (UIView <MGLayoutBox> *box in disappearingBoxesWithAnimation) {
-            NSUInteger index = [provider oldIndexOfBox:box];
-            [provider doDisappearAnimationFor:box atIndex:index duration:duration];
+            if (CGRectIntersectsRect(box.frame, viewport)) {
+                [animatedDisappears addObject:box];
+            }
+        }
+        for (UIView <MGLayoutBox> *box in appearingBoxesWithAnimation) {
+            if (CGRectIntersectsRect(box.frame, viewport)) {
+                [animatedAppears addObject:box];
+            }
+        }
+        for (UIView <MGLayoutBox> *box in movingBoxes) {
+            CGRect toFrame = [provider frameForBoxAtIndex:[provider indexOfBox:box]];
+            if (CGRectIntersectsRect(box.frame, viewport)
+                  || CGRectIntersectsRect(toFrame, viewport)) {
+                [animatedMoves addObject:box];
+            }
         }
     }
+    NSUInteger changes = animatedDisappears.count + animatedAppears.count + animatedMoves.count;
+    BOOL crossfade = provider.maxAnimatedChanges && changes > provider.maxAnimatedChanges;
 
-    // do appear animations
-    if (duration) {
-        for (UIView <MGLayoutBox> *box in appearingBoxesWithAnimation) {
+    // custom animation blocks animate themselves, outside the pass's transaction
+    BOOL customDisappear = provider.disappearAnimation && !crossfade;
+    BOOL customAppear = provider.appearAnimation && !crossfade;
+    BOOL customMove = provider.moveAnimation && !crossfade;
+    BOOL customAnimated = (customDisappear && animatedDisappears.count)
+          || (customAppear && animatedAppears.count) || (customMove && animatedMoves.count);
+
+    // final positions and states, animated or not
+    MGBlock changeStates = ^{
+        for (UIView <MGLayoutBox> *box in disappearingBoxesWithAnimation) {
+            if ([animatedDisappears containsObject:box] && !crossfade) {
+                if (!customDisappear) {
+                    NSUInteger index = [provider oldIndexOfBox:box];
+                    [provider doDisappearAnimationFor:box atIndex:index duration:duration];
+                }
+            } else {
+                box.hidden = YES;
+            }
+        }
+        if (!crossfade && !customAppear) {
+            for (UIView <MGLayoutBox> *box in animatedAppears) {
+                NSUInteger index = [provider indexOfBox:box];
+                [provider doAppearAnimationFor:box atIndex:index duration:duration];
+            }
+        }
+        for (UIView <MGLayoutBox> *box in movingBoxes) {
+            NSUInteger index = [provider indexOfBox:box];
+            CGRect toFrame = [provider frameForBoxAtIndex:index];
+            if ([animatedMoves containsObject:box] && !crossfade) {
+                if (!customMove) {
+                    [provider doMoveAnimationFor:box atIndex:index duration:duration
+                                       fromFrame:box.frame toFrame:toFrame];
+                }
+            } else if (!duration) {
+                box.frame = toFrame;
+            } else {
+                [UIView performWithoutAnimation:^{
+                    box.frame = toFrame;
+                }];
+            }
+        }
+    };
+
+    // remove the removeables and finish up. boxes reused in the meantime stay
+    MGBlock fini = ^{
+        for (UIView <MGLayoutBox> *box in disappearingBoxesWithAnimation) {
+            if ([provider indexOfBox:box] == NSNotFound) {
+                box.hidden = YES;
+            }
+        }
+        if (completion) {
+            completion();
+        }
+    };
+
+    // custom animations can outlast the transaction, so finish no sooner than
+    // the pass's duration
+    CFTimeInterval start = CACurrentMediaTime();
+    void (^finish)(BOOL) = ^(BOOL done) {
+        NSTimeInterval left = customAnimated ? start + duration - CACurrentMediaTime() : 0;
+        if (left > 0) {
+            dispatch_after(dispatch_time(0, (int64_t)(left * NSEC_PER_SEC)),
+                  dispatch_get_main_queue(), fini);
+        } else {
+            fini();
+        }
+    };
+
+    // one transaction for the whole pass, or a single crossfade for big changes
+    UIViewAnimationOptions options = UIViewAnimationOptionAllowUserInteraction
+          | UIViewAnimationOptionBeginFromCurrentState;
+    if (!changes) {
+        changeStates();
+    } else if (crossfade) {
+        [UIView transitionWithView:container duration:duration
+              options:options | UIViewAnimationOptionTransitionCrossDissolve
+              animations:changeStates completion:finish];
+    } else {
+        [UIView animateWithDuration:duration delay:0 options:options
+              animations:changeStates completion:finish];
+    }
+    if (customDisappear) {
+        for (UIView <MGLayoutBox> *box in disappearingBoxesWithAnimation) {
+            if ([animatedDisappears containsObject:box]) {
+                NSUInteger index = [provider oldIndexOfBox:box];
+                [provider doDisappearAnimationFor:box atIndex:index duration:duration];
+            }
+        }
+    }
+    if (customAppear) {
+        for (UIView <MGLayoutBox> *box in animatedAppears) {
             NSUInteger index = [provider indexOfBox:box];
             [provider doAppearAnimationFor:box atIndex:index duration:duration];
         }
     }
+    if (customMove) {
+        for (UIView <MGLayoutBox> *box in movingBoxes) {
+            if ([animatedMoves containsObject:box]) {
+                NSUInteger index = [provider indexOfBox:box];
+                CGRect toFrame = [provider frameForBoxAtIndex:index];
+                [provider doMoveAnimationFor:box atIndex:index duration:duration
+                                   fromFrame:box.frame toFrame:toFrame];
+            }
+        }
+    }
 
-    // do move animations
     for (UIView <MGLayoutBox> *box in movingBoxes) {
-        NSUInteger index = [provider indexOfBox:box];
-        CGRect toFrame = [provider frameForBoxAtIndex:index];
-        if (duration) {
-            [provider doMoveAnimationFor:box atIndex:index duration:duration
-                               fromFrame:box.frame toFrame:toFrame];
-        } else {
-            box.frame = toFrame;
-        }
         if ([box respondsToSelector:@selector(movedToIndex:)]) {
-            [box movedToIndex:index];
+            [box movedToIndex:[provider indexOfBox:box]];
         }
     }
 
@@ -206,36 +390,25 @@ CGFloat roundToPixel(CGFloat value) {
         }
     }
 
-    // remove the removeables and finish up
-    MGBlock fini = ^{
-        for (UIView <MGLayoutBox> *box in disappearingBoxesWithAnimation) {
-            box.hidden = YES;
-        }
-        if (completion) {
-            completion();
-        }
-    };
+    // nested scrollers that have come on screen
+    [provider layoutNestedScrollers];
 
-    if (duration) {
-        dispatch_after(dispatch_time(0,
-                                     (int64_t)(duration * NSEC_PER_SEC)),
-                                        dispatch_get_main_queue(), ^{
-             fini();
-        });
-    } else {
+    if (!changes) {
         fini();
     }
 }
 
-+ (NSOrderedSet *)framesForBoxesIn:(UIView <MGLayoutBox> *)container {
-    switch (container.contentLayoutMode) {
-        case MGLayoutTableStyle:
-            return [self stackTableStyle:container];
-        case MGLayoutGridStyle:
-            return [self stackGridStyle:container];
-        default:
-            return nil;
++ (MGBoxFrameIndex *)framesForBoxesIn:(UIView <MGLayoutBox> *)container {
+    if (container.boxProvider.hasGridBoxes) {
+        return [self gridFramesForBoxesIn:container];
+    }
+    if (container.boxProvider.hasUniformBoxes) {
+        return [self uniformFramesForBoxesIn:container];
     }
+    MGBoxFrameIndex *frames = [MGBoxFrameIndex
+          frameIndexWithCapacity:container.boxProvider.count];
+    [self stackFramesIn:container into:frames];
+    return frames;
 }
 
 + (void)positionBoxesIn:(UIView <MGLayoutBox> *)container {
@@ -246,6 +419,9 @@ CGFloat roundToPixel(CGFloat value) {
         case MGLayoutGridStyle:
             [self stackGridStyle:container onlyMove:nil];
             break;
+        case MGLayoutMasonryStyle:
+            [self stackMasonryStyle:container onlyMove:nil];
+            break;
     }
 
     // position attached and replacement boxes
@@ -258,6 +434,16 @@ CGFloat roundToPixel(CGFloat value) {
 + (void)layoutBoxesIn:(UIView <MGLayoutBox> *)container duration:(NSTimeInterval)duration
       completion:(MGBlock)completion {
 
+  // nested scroller waiting to come on screen?
+  if (container.boxProvider.nestedLayoutDeferred) {
+    return;
+  }
+
+  // batching, mid animation, or mid layout? then coalesce into a later layout
+  if ([container.boxProvider deferLayoutWithDuration:duration completion:completion]) {
+    return;
+  }
+
   // layout locked?
   if (container.layingOut) {
     return;
@@ -266,13 +452,34 @@ CGFloat roundToPixel(CGFloat value) {
 
   // box provider style layout
   if (container.boxProvider) {
+    MGBoxProvider *provider = container.boxProvider;
+    MGBlock fini = completion;
+    if (duration) {
+      [provider layoutAnimationDidStart];
+      fini = ^{
+        if (completion) {
+          completion();
+        }
+        [provider layoutAnimationDidEnd];
+      };
+    }
+    MGLayoutTimings timings = {0};
+    CFTimeInterval start = CACurrentMediaTime(), mark = start;
     [container.boxProvider updateDataKeys];
+    timings.dataKeys = MGLapTime(&mark);
     [container.boxProvider updateBoxFrames];
+    timings.boxFrames = MGLapTime(&mark);
     [container.boxProvider updateVisibleIndexes];
-    [self layoutVisibleBoxesIn:container duration:duration completion:completion];
+    timings.visibleIndexes = MGLapTime(&mark);
+    [self layoutVisibleBoxesIn:container duration:duration completion:fini];
+    timings.boxes = MGLapTime(&mark);
     [container.boxProvider updateOldDataKeys];
     [self updateContentSizeFor:container];
     [container.boxProvider updateOldBoxFrames];
+    timings.total = CACurrentMediaTime() - start;
+    [provider recordLayoutTimings:timings];
+    [provider.sessionRecorder recordLayout:duration ? MGTraceAnimatedLayout : MGTraceFullLayout
+          duration:timings.total];
     container.layingOut = NO;
     return;
   }
@@ -352,6 +559,9 @@ CGFloat roundToPixel(CGFloat value) {
     case MGLayoutGridStyle:
       [MGLayoutManager stackGridStyle:container onlyMove:newNotTopBoxes];
       break;
+    case MGLayoutMasonryStyle:
+      [MGLayoutManager stackMasonryStyle:container onlyMove:newNotTopBoxes];
+      break;
   }
 
   // everyone in now please
@@ -404,12 +614,38 @@ CGFloat roundToPixel(CGFloat value) {
 
 #pragma mark - Layout strategies
 
-+ (NSOrderedSet *)stackGridStyle:(UIView <MGLayoutBox> *)container {
++ (void)stackFramesIn:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames {
+    [self stackFramesIn:container into:frames count:container.boxProvider.count];
+}
+
+// stacks frames up to the given count. the index keeps the stacking state, so
+// a later call carries on from where this one stopped
++ (void)stackFramesIn:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames
+      count:(NSUInteger)count {
+    count = MIN(count, container.boxProvider.count);
+    if (!frames.count) {
+        frames.cursor = (CGPoint){container.leftPadding, container.topPadding};
+        frames.rowBottom = 0;
+    }
+    switch (container.contentLayoutMode) {
+        case MGLayoutTableStyle:
+            [self stackTableStyle:container into:frames count:count];
+            break;
+        case MGLayoutGridStyle:
+            [self stackGridStyle:container into:frames count:count];
+            break;
+        case MGLayoutMasonryStyle:
+            [self stackMasonryStyle:container into:frames count:count];
+            break;
+    }
+}
+
++ (void)stackGridStyle:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames
+      count:(NSUInteger)count {
     MGBoxProvider *provider = container.boxProvider;
-    NSMutableOrderedSet *frames = [NSMutableOrderedSet orderedSetWithCapacity:provider.count];
 
-    CGFloat x = container.leftPadding, y = container.topPadding, rowBottom = 0;
-    for (int index = 0; index < provider.count; index++) {
+    CGFloat x = frames.cursor.x, y = frames.cursor.y, rowBottom = frames.rowBottom;
+    for (NSUInteger index = frames.count; index < count; index++) {
         UIEdgeInsets margin = [provider marginForBoxAtIndex:index];
         CGRect frame = (CGRect){
               (CGPoint){roundToPixel(x + margin.left), roundToPixel(y + margin.top)},
@@ -429,28 +665,114 @@ CGFloat roundToPixel(CGFloat value) {
         x = CGRectGetMaxX(frame) + margin.right;
         rowBottom = MAX(rowBottom, CGRectGetMaxY(frame) + margin.bottom);
 
-        frames[index] = [NSValue valueWithCGRect:frame];
+        [frames addFrame:frame margin:margin];
     }
 
-    return frames;
+    frames.cursor = (CGPoint){x, y};
+    frames.rowBottom = rowBottom;
 }
 
-+ (NSOrderedSet *)stackTableStyle:(UIView <MGLayoutBox> *)container {
++ (void)stackTableStyle:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames
+      count:(NSUInteger)count {
     MGBoxProvider *provider = container.boxProvider;
-    NSMutableOrderedSet *frames = [NSMutableOrderedSet orderedSetWithCapacity:provider.count];
 
-    CGFloat y = container.topPadding;
-    for (int index = 0; index < provider.count; index++) {
+    CGFloat y = frames.cursor.y;
+    for (NSUInteger index = frames.count; index < count; index++) {
         UIEdgeInsets margin = [provider marginForBoxAtIndex:index];
         CGRect frame = (CGRect){
               (CGPoint){container.leftPadding + margin.left, y + margin.top},
               [provider sizeForBoxAtIndex:index]
         };
         y = CGRectGetMaxY(frame) + margin.bottom;
-        frames[index] = [NSValue valueWithCGRect:frame];
+        [frames addFrame:frame margin:margin];
     }
 
-    return frames;
+    frames.cursor = (CGPoint){container.leftPadding, y};
+}
+
++ (void)stackMasonryStyle:(UIView <MGLayoutBox> *)container into:(MGBoxFrameIndex *)frames
+      count:(NSUInteger)count {
+    MGBoxProvider *provider = container.boxProvider;
+
+    for (NSUInteger index = frames.count; index < count; index++) {
+        UIEdgeInsets margin = [provider marginForBoxAtIndex:index];
+        CGSize size = [provider sizeForBoxAtIndex:index];
+
+        // the first box decides the columns
+        if (!frames.columnCount) {
+            [self resetColumnsIn:frames forContainer:container
+                  firstBoxWidth:size.width + margin.left + margin.right];
+        }
+
+        // each box goes in the shortest column
+        NSUInteger column = frames.shortestColumn;
+        CGRect frame = (CGRect){
+              (CGPoint){
+                    roundToPixel(container.leftPadding + column * frames.columnWidth + margin.left),
+                    roundToPixel([frames heightOfColumn:column] + margin.top)
+              },
+              size
+        };
+        [frames setHeightOfShortestColumn:CGRectGetMaxY(frame) + margin.bottom];
+        [frames addFrame:frame margin:margin];
+    }
+}
+
++ (MGBoxFrameIndex *)uniformFramesForBoxesIn:(UIView <MGLayoutBox> *)container {
+    MGBoxProvider *provider = container.boxProvider;
+    CGSize size = provider.uniformBoxSize;
+    UIEdgeInsets margin = provider.uniformBoxMargin;
+
+    // same wrapping rule as stackGridStyle, but worked out once
+    NSUInteger columns = 1;
+    if (container.contentLayoutMode != MGLayoutTableStyle) {
+        columns = provider.columnCount;
+        CGFloat cellWidth = margin.left + size.width + margin.right;
+        if (!columns && cellWidth > 0) {
+            columns = (NSUInteger)MAX(floor((container.width - container.leftPadding) / cellWidth), 1);
+        }
+    }
+
+    return [MGBoxFrameIndex uniformFrameIndexWithCount:provider.count
+          origin:(CGPoint){container.leftPadding, container.topPadding}
+          boxSize:size margin:margin columns:columns];
+}
+
++ (MGBoxFrameIndex *)gridFramesForBoxesIn:(UIView <MGLayoutBox> *)container {
+    MGBoxProvider *provider = container.boxProvider;
+    NSUInteger count = provider.count, columns = MAX(provider.columnCount, 1);
+    NSUInteger rows = (count + columns - 1) / columns;
+
+    NSData *rowEdges = [self edgesForCount:rows maker:provider.rowHeightMaker
+          length:provider.uniformBoxSize.height];
+    NSData *columnEdges = [self edgesForCount:MIN(columns, count)
+          maker:provider.columnWidthMaker length:provider.uniformBoxSize.width];
+
+    return [MGBoxFrameIndex gridFrameIndexWithCount:count
+          origin:(CGPoint){container.leftPadding, container.topPadding}
+          rowEdges:rowEdges columnEdges:columnEdges margin:provider.uniformBoxMargin];
+}
+
+// running totals of the given heights or widths, starting from zero
++ (NSData *)edgesForCount:(NSUInteger)count maker:(MGBoxDimensionMaker)maker
+      length:(CGFloat)length {
+    NSMutableData *data = [NSMutableData dataWithLength:(count + 1) * sizeof(CGFloat)];
+    CGFloat *edges = data.mutableBytes;
+    for (NSUInteger i = 0; i < count; i++) {
+        edges[i + 1] = edges[i] + (maker ? maker(i) : length);
+    }
+    return data;
+}
+
++ (void)resetColumnsIn:(MGBoxFrameIndex *)frames forContainer:(UIView <MGLayoutBox> *)container
+      firstBoxWidth:(CGFloat)boxWidth {
+    CGFloat innerWidth = container.width - container.leftPadding - container.rightPadding;
+    NSUInteger columns = container.boxProvider.columnCount;
+    if (!columns) {
+        columns = boxWidth > 0 ? (NSUInteger)MAX(floor(innerWidth / boxWidth), 1) : 1;
+    }
+    frames.columnWidth = innerWidth / columns;
+    [frames resetColumns:columns top:container.topPadding];
 }
 
 + (void)stackTableStyle:(UIView <MGLayoutBox> *)container
@@ -516,6 +838,40 @@ CGFloat roundToPixel(CGFloat value) {
     [self updateContentSizeFor:container];
 }
 
++ (void)stackMasonryStyle:(UIView <MGLayoutBox> *)container
+                 onlyMove:(NSSet *)only {
+  MGBoxFrameIndex *columns = [MGBoxFrameIndex frameIndexWithCapacity:0];
+
+  // lay out automatic boxes
+  for (UIView <MGLayoutBox> *box in container.boxes) {
+    if (box.boxLayoutMode != MGBoxLayoutAutomatic) {
+      continue;
+    }
+
+    // first box decides the columns
+    if (!columns.columnCount) {
+      [self resetColumnsIn:columns forContainer:container
+          firstBoxWidth:box.leftMargin + box.width + box.rightMargin];
+    }
+
+    // shortest column gets the box
+    NSUInteger column = columns.shortestColumn;
+    CGFloat y = [columns heightOfColumn:column] + box.topMargin;
+    if (!only || [only containsObject:box]) {
+      box.origin = CGPointMake(roundToPixel(container.leftPadding
+          + column * columns.columnWidth + box.leftMargin), roundToPixel(y));
+    }
+    [columns setHeightOfShortestColumn:y + box.height + box.bottomMargin];
+  }
+
+  // don't update size if we weren't positioning everyone
+  if (only) {
+    return;
+  }
+
+    [self updateContentSizeFor:container];
+}
+
 + (void)positionAttachedBoxesIn:(UIView <MGLayoutBox> *)container {
   for (UIView <MGLayoutBox> *box in container.boxes) {
     if (box.boxLayoutMode == MGBoxLayoutAttached) {
@@ -614,13 +970,9 @@ CGFloat roundToPixel(CGFloat value) {
     }
 
     if (container.boxProvider) {
-        MGBoxProvider *provider = container.boxProvider;
-        for (int index = 0; index < provider.count; index++) {
-            CGRect frame = [provider frameForBoxAtIndex:index];
-            UIEdgeInsets margin = [provider marginForBoxAtIndex:index];
-            newSize.width = MAX(newSize.width, CGRectGetMaxX(frame) + margin.right);
-            newSize.height = MAX(newSize.height, CGRectGetMaxY(frame) + margin.bottom);
-        }
+        CGSize extent = container.boxProvider.estimatedBoxFramesExtent;
+        newSize.width = MAX(newSize.width, extent.width);
+        newSize.height = MAX(newSize.height, extent.height);
 
     } else {
         for (UIView <MGLayoutBox> *box in container.boxes) {
@@ -4,6 +4,7 @@
 //
 
 #import "MGBox.h"
+#import "MGLineStyle.h"
 
 typedef enum {
   MGSidePrecedenceLeft, MGSidePrecedenceRight, MGSidePrecedenceMiddle
@@ -13,8 +14,6 @@ typedef enum {
   MGVerticalAlignmentTop, MGVerticalAlignmentCenter, MGVerticalAlignmentBottom
 } MGVerticalAlignment;
 
-typedef enum { MGLeft, MGMiddle, MGRight } MGItemPlacement;
-
 /**
 `MGLine` is roughly equivalent to `UITableViewCell`, functioning as a base
 class for table rows. It can also be used generically as a layout container
@@ -208,6 +207,26 @@ MGLayoutBox, their [topMargin](-[MGLayoutBox topMargin]) and
 
 #pragma mark - Styling
 
+/** @name Shared styles */
+
+/**
+All of the line's text style properties at once, as an immutable
+<MGLineStyle> that can be shared between many lines.
+
+Assigning a style sets every style property, and updates the colours and
+shadows of existing labels in a single pass over the items, instead of one pass
+per property setter. Assigning the style that's already applied does nothing,
+so reused rows can be given their style on every reuse for free. New labels
+take their attributes straight from the style.
+
+Changing any individual style property afterwards detaches the line from the
+shared style, and the getter then returns a style made from the line's current
+properties.
+
+    line.lineStyle = self.rowStyle;
+*/
+@property (nonatomic, copy) MGLineStyle *lineStyle;
+
 /** @name Fonts */
 
 /**
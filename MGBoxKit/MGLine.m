@@ -6,6 +6,7 @@
 #import <tgmath.h>
 #import "MGLine.h"
 #import "MGLayoutManager.h"
+#import "MGAsyncLayoutScheduler.h"
 #import "MGMushParser.h"
 #import "NSAttributedString+MGTrim.h"
 #import "NSString+MGEasySize.h"
@@ -17,7 +18,7 @@
 @implementation MGLine {
   CGFloat leftUsed, middleUsed, rightUsed;
   NSMutableArray *_leftItems, *_middleItems, *_rightItems;
-  BOOL asyncDrawing, asyncDrawOnceing;
+  MGLineStyle *_lineStyle;
 }
 
 - (void)setup {
@@ -25,19 +26,11 @@
 
   self.dontFit = @[].mutableCopy;
 
-  // default font styles
-  self.font = [UIFont fontWithName:@"HelveticaNeue-Light" size:16];
-  self.textColor = UIColor.blackColor;
-  self.textShadowColor = UIColor.clearColor;
-  self.leftTextShadowOffset = (CGSize){0, 1};
-  self.middleTextShadowOffset = (CGSize){0, 1};
-  self.rightTextShadowOffset = (CGSize){0, 1};
+  // default font styles and horizontal alignments, shared by all lines
+  self.lineStyle = MGLineStyle.defaultStyle;
   self.opaqueLabels = NO;
 
-  // default horizontal and vertical alignments
-  self.leftItemsAlignment = NSTextAlignmentLeft;
-  self.middleItemsAlignment = NSTextAlignmentCenter;
-  self.rightItemsAlignment = NSTextAlignmentRight;
+  // default vertical alignment
   self.verticalAlignment = MGVerticalAlignmentCenter;
 
   // default item layout precedence
@@ -257,21 +250,9 @@
   [MGLayoutManager stackByZIndexIn:self];
 
   // async draws
-  if (self.asyncLayout || self.asyncLayoutOnce) {
-    dispatch_async(self.asyncQueue, ^{
-        if (self.asyncLayout && !self->asyncDrawing) {
-            self->asyncDrawing = YES;
-            self.asyncLayout();
-            self->asyncDrawing = NO;
-        }
-        if (self.asyncLayoutOnce && !self->asyncDrawOnceing) {
-            self->asyncDrawOnceing = YES;
-            self.asyncLayoutOnce();
-            self.asyncLayoutOnce = nil;
-            self->asyncDrawOnceing = NO;
-        }
-    });
-  }
+  [MGAsyncLayoutScheduler.sharedScheduler scheduleLayoutFor:self];
+
+  [self updateAsyncDisplay];
 }
 
 - (void)wrapRawContents:(NSMutableArray *)items
@@ -585,29 +566,12 @@
       : UIColor.clearColor;
 
   // styling
-  switch (placement) {
-    case MGLeft:
-      label.font = self.font;
-      label.textAlignment = self.leftItemsAlignment;
-      label.shadowOffset = self.leftTextShadowOffset;
-      label.shadowColor = self.textShadowColor;
-      label.textColor = self.textColor;
-      break;
-    case MGMiddle:
-      label.font = self.middleFont ? : self.font;
-      label.textAlignment = self.middleItemsAlignment;
-      label.shadowOffset = self.middleTextShadowOffset;
-      label.shadowColor = self.middleTextShadowColor ? : self.textShadowColor;
-      label.textColor = self.middleTextColor ? : self.textColor;
-      break;
-    case MGRight:
-      label.font = self.rightFont ? : self.font;
-      label.textAlignment = self.rightItemsAlignment;
-      label.shadowOffset = self.rightTextShadowOffset;
-      label.shadowColor = self.rightTextShadowColor ? : self.textShadowColor;
-      label.textColor = self.rightTextColor ? : self.textColor;
-      break;
-  }
+  MGLineStyle *style = self.lineStyle;
+  label.font = [style fontFor:placement];
+  label.textAlignment = [style itemsAlignmentFor:placement];
+  label.shadowOffset = [style textShadowOffsetFor:placement];
+  label.shadowColor = [style textShadowColorFor:placement];
+  label.textColor = [style textColorFor:placement];
 
   // newline chars trigger a multiline label
   NSString *plain = [text isKindOfClass:NSAttributedString.class]
@@ -649,17 +613,7 @@
   }
 
   // need to reset text alignment due to being overwritten in the attributed string attribs
-  switch (placement) {
-    case MGLeft:
-      label.textAlignment = self.leftItemsAlignment;
-      break;
-    case MGMiddle:
-      label.textAlignment = self.middleItemsAlignment;
-      break;
-    case MGRight:
-      label.textAlignment = self.rightItemsAlignment;
-      break;
-  }
+  label.textAlignment = [style itemsAlignmentFor:placement];
 
   // final resizing will be done at layout time
   if ([label respondsToSelector:@selector(attributedText)]) {
@@ -685,10 +639,97 @@
   return label;
 }
 
+#pragma mark - Shared style
+
+- (void)setLineStyle:(MGLineStyle *)style {
+  style = style ? style.copy : MGLineStyle.defaultStyle;
+  if (style == _lineStyle) {
+    return;
+  }
+  _lineStyle = style;
+
+  // straight to the ivars, skipping the setters' label walks
+  _font = style.font;
+  _middleFont = style.middleFont;
+  _rightFont = style.rightFont;
+  _textColor = style.textColor;
+  _middleTextColor = style.middleTextColor;
+  _rightTextColor = style.rightTextColor;
+  _textShadowColor = style.textShadowColor;
+  _middleTextShadowColor = style.middleTextShadowColor;
+  _rightTextShadowColor = style.rightTextShadowColor;
+  _leftTextShadowOffset = style.leftTextShadowOffset;
+  _middleTextShadowOffset = style.middleTextShadowOffset;
+  _rightTextShadowOffset = style.rightTextShadowOffset;
+  _leftItemsAlignment = style.leftItemsAlignment;
+  _middleItemsAlignment = style.middleItemsAlignment;
+  _rightItemsAlignment = style.rightItemsAlignment;
+  _leftLineSpacing = style.leftLineSpacing;
+  _middleLineSpacing = style.middleLineSpacing;
+  _rightLineSpacing = style.rightLineSpacing;
+
+  // then one walk over the labels, with each column's attributes resolved once
+  NSArray *columns[] = {_leftItems, _middleItems, _rightItems};
+  for (MGItemPlacement placement = MGLeft; placement <= MGRight; placement++) {
+    UIColor *textColor = [style textColorFor:placement];
+    UIColor *shadowColor = [style textShadowColorFor:placement];
+    CGSize shadowOffset = [style textShadowOffsetFor:placement];
+    for (UILabel *label in columns[placement]) {
+      if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
+        label.textColor = textColor;
+        label.shadowColor = shadowColor;
+        label.shadowOffset = shadowOffset;
+      }
+    }
+  }
+}
+
+- (MGLineStyle *)lineStyle {
+  if (!_lineStyle) {
+    MGMutableLineStyle *style = MGMutableLineStyle.new;
+    style.font = _font;
+    style.middleFont = _middleFont;
+    style.rightFont = _rightFont;
+    style.textColor = _textColor;
+    style.middleTextColor = _middleTextColor;
+    style.rightTextColor = _rightTextColor;
+    style.textShadowColor = _textShadowColor;
+    style.middleTextShadowColor = _middleTextShadowColor;
+    style.rightTextShadowColor = _rightTextShadowColor;
+    style.leftTextShadowOffset = _leftTextShadowOffset;
+    style.middleTextShadowOffset = _middleTextShadowOffset;
+    style.rightTextShadowOffset = _rightTextShadowOffset;
+    style.leftItemsAlignment = _leftItemsAlignment;
+    style.middleItemsAlignment = _middleItemsAlignment;
+    style.rightItemsAlignment = _rightItemsAlignment;
+    style.leftLineSpacing = _leftLineSpacing;
+    style.middleLineSpacing = _middleLineSpacing;
+    style.rightLineSpacing = _rightLineSpacing;
+    _lineStyle = style.copy;
+  }
+  return _lineStyle;
+}
+
 #pragma mark - Style setters
 
+- (void)setFont:(UIFont *)font {
+  _font = font;
+  _lineStyle = nil;
+}
+
+- (void)setMiddleFont:(UIFont *)font {
+  _middleFont = font;
+  _lineStyle = nil;
+}
+
+- (void)setRightFont:(UIFont *)font {
+  _rightFont = font;
+  _lineStyle = nil;
+}
+
 - (void)setTextColor:(UIColor *)color {
   _textColor = color;
+  _lineStyle = nil;
   NSMutableArray *items = self.leftItems.mutableCopy;
   if (!self.middleTextColor) {
     [items addObjectsFromArray:self.middleItems];
@@ -705,6 +746,7 @@
 
 - (void)setMiddleTextColor:(UIColor *)color {
   _middleTextColor = color;
+  _lineStyle = nil;
   for (UILabel *label in self.middleItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.textColor = color;
@@ -714,6 +756,7 @@
 
 - (void)setRightTextColor:(UIColor *)color {
   _rightTextColor = color;
+  _lineStyle = nil;
   for (UILabel *label in self.rightItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.textColor = color;
@@ -723,6 +766,7 @@
 
 - (void)setTextShadowColor:(UIColor *)color {
   _textShadowColor = color;
+  _lineStyle = nil;
   NSMutableArray *items = self.leftItems.mutableCopy;
   if (!self.middleTextShadowColor) {
     [items addObjectsFromArray:self.middleItems];
@@ -739,6 +783,7 @@
 
 - (void)setMiddleTextShadowColor:(UIColor *)color {
   _middleTextShadowColor = color;
+  _lineStyle = nil;
   for (UILabel *label in self.middleItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.shadowColor = color;
@@ -748,6 +793,7 @@
 
 - (void)setRightTextShadowColor:(UIColor *)color {
   _rightTextShadowColor = color;
+  _lineStyle = nil;
   for (UILabel *label in self.rightItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.shadowColor = color;
@@ -757,6 +803,7 @@
 
 - (void)setLeftTextShadowOffset:(CGSize)offset {
   _leftTextShadowOffset = offset;
+  _lineStyle = nil;
   for (UILabel *label in self.leftItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.shadowOffset = offset;
@@ -766,6 +813,7 @@
 
 - (void)setMiddleTextShadowOffset:(CGSize)offset {
   _middleTextShadowOffset = offset;
+  _lineStyle = nil;
   for (UILabel *label in self.middleItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.shadowOffset = offset;
@@ -775,6 +823,7 @@
 
 - (void)setRightTextShadowOffset:(CGSize)offset {
   _rightTextShadowOffset = offset;
+  _lineStyle = nil;
   for (UILabel *label in self.rightItems) {
     if ([label isKindOfClass:UILabel.class] && label.tag == -1) {
       label.shadowOffset = offset;
@@ -782,6 +831,36 @@
   }
 }
 
+- (void)setLeftItemsAlignment:(NSTextAlignment)alignment {
+  _leftItemsAlignment = alignment;
+  _lineStyle = nil;
+}
+
+- (void)setMiddleItemsAlignment:(NSTextAlignment)alignment {
+  _middleItemsAlignment = alignment;
+  _lineStyle = nil;
+}
+
+- (void)setRightItemsAlignment:(NSTextAlignment)alignment {
+  _rightItemsAlignment = alignment;
+  _lineStyle = nil;
+}
+
+- (void)setLeftLineSpacing:(CGFloat)spacing {
+  _leftLineSpacing = spacing;
+  _lineStyle = nil;
+}
+
+- (void)setMiddleLineSpacing:(CGFloat)spacing {
+  _middleLineSpacing = spacing;
+  _lineStyle = nil;
+}
+
+- (void)setRightLineSpacing:(CGFloat)spacing {
+  _rightLineSpacing = spacing;
+  _lineStyle = nil;
+}
+
 #pragma mark - Content setters
 
 - (void)setLeftItems:(id)items {
@@ -0,0 +1,105 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+typedef enum { MGLeft, MGMiddle, MGRight } MGItemPlacement;
+
+@class MGMutableLineStyle;
+
+/**
+An immutable set of `MGLine` text styles (fonts, text colours, shadow colours
+and offsets, item alignments, and line spacings, for each of the left, middle,
+and right columns), for sharing between many lines, eg all the rows of a table.
+
+    MGMutableLineStyle *style = MGLineStyle.defaultStyle.mutableCopy;
+    style.font = [UIFont systemFontOfSize:14];
+    style.rightTextColor = UIColor.grayColor;
+    self.rowStyle = style.copy;
+
+    line.lineStyle = self.rowStyle;
+
+As with the line's own properties, middle and right fonts and colours that are
+`nil` fall back to the left ones.
+*/
+@interface MGLineStyle : NSObject <NSCopying, NSMutableCopying>
+
+/**
+* The style of a newly made `MGLine`. Shared by every line until its style
+* properties are changed.
+*/
++ (MGLineStyle *)defaultStyle;
+
+/** @name Fonts */
+
+@property (nonatomic, readonly) UIFont *font;
+@property (nonatomic, readonly) UIFont *middleFont;
+@property (nonatomic, readonly) UIFont *rightFont;
+
+/** @name Text colours */
+
+@property (nonatomic, readonly) UIColor *textColor;
+@property (nonatomic, readonly) UIColor *middleTextColor;
+@property (nonatomic, readonly) UIColor *rightTextColor;
+
+/** @name Text shadows */
+
+@property (nonatomic, readonly) UIColor *textShadowColor;
+@property (nonatomic, readonly) UIColor *middleTextShadowColor;
+@property (nonatomic, readonly) UIColor *rightTextShadowColor;
+@property (nonatomic, readonly) CGSize leftTextShadowOffset;
+@property (nonatomic, readonly) CGSize middleTextShadowOffset;
+@property (nonatomic, readonly) CGSize rightTextShadowOffset;
+
+/** @name Alignments and line spacing */
+
+@property (nonatomic, readonly) NSTextAlignment leftItemsAlignment;
+@property (nonatomic, readonly) NSTextAlignment middleItemsAlignment;
+@property (nonatomic, readonly) NSTextAlignment rightItemsAlignment;
+@property (nonatomic, readonly) CGFloat leftLineSpacing;
+@property (nonatomic, readonly) CGFloat middleLineSpacing;
+@property (nonatomic, readonly) CGFloat rightLineSpacing;
+
+/** @name Column attributes */
+
+/**
+* The attributes for labels in the given column, with the fallbacks applied.
+*/
+- (UIFont *)fontFor:(MGItemPlacement)placement;
+- (UIColor *)textColorFor:(MGItemPlacement)placement;
+- (UIColor *)textShadowColorFor:(MGItemPlacement)placement;
+- (CGSize)textShadowOffsetFor:(MGItemPlacement)placement;
+- (NSTextAlignment)itemsAlignmentFor:(MGItemPlacement)placement;
+- (CGFloat)lineSpacingFor:(MGItemPlacement)placement;
+
+@end
+
+/**
+* A mutable `MGLineStyle`, for building styles. Lines keep an immutable copy.
+*/
+@interface MGMutableLineStyle : MGLineStyle
+
+@property (nonatomic, retain) UIFont *font;
+@property (nonatomic, retain) UIFont *middleFont;
+@property (nonatomic, retain) UIFont *rightFont;
+
+@property (nonatomic, retain) UIColor *textColor;
+@property (nonatomic, retain) UIColor *middleTextColor;
+@property (nonatomic, retain) UIColor *rightTextColor;
+
+@property (nonatomic, retain) UIColor *textShadowColor;
+@property (nonatomic, retain) UIColor *middleTextShadowColor;
+@property (nonatomic, retain) UIColor *rightTextShadowColor;
+@property (nonatomic, assign) CGSize leftTextShadowOffset;
+@property (nonatomic, assign) CGSize middleTextShadowOffset;
+@property (nonatomic, assign) CGSize rightTextShadowOffset;
+
+@property (nonatomic, assign) NSTextAlignment leftItemsAlignment;
+@property (nonatomic, assign) NSTextAlignment middleItemsAlignment;
+@property (nonatomic, assign) NSTextAlignment rightItemsAlignment;
+@property (nonatomic, assign) CGFloat leftLineSpacing;
+@property (nonatomic, assign) CGFloat middleLineSpacing;
+@property (nonatomic, assign) CGFloat rightLineSpacing;
+
+@end
@@ -0,0 +1,167 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGLineStyle.h"
+
+@interface MGLineStyle ()
+
+@property (nonatomic, retain) UIFont *font;
+@property (nonatomic, retain) UIFont *middleFont;
+@property (nonatomic, retain) UIFont *rightFont;
+
+@property (nonatomic, retain) UIColor *textColor;
+@property (nonatomic, retain) UIColor *middleTextColor;
+@property (nonatomic, retain) UIColor *rightTextColor;
+
+@property (nonatomic, retain) UIColor *textShadowColor;
+@property (nonatomic, retain) UIColor *middleTextShadowColor;
+@property (nonatomic, retain) UIColor *rightTextShadowColor;
+@property (nonatomic, assign) CGSize leftTextShadowOffset;
+@property (nonatomic, assign) CGSize middleTextShadowOffset;
+@property (nonatomic, assign) CGSize rightTextShadowOffset;
+
+@property (nonatomic, assign) NSTextAlignment leftItemsAlignment;
+@property (nonatomic, assign) NSTextAlignment middleItemsAlignment;
+@property (nonatomic, assign) NSTextAlignment rightItemsAlignment;
+@property (nonatomic, assign) CGFloat leftLineSpacing;
+@property (nonatomic, assign) CGFloat middleLineSpacing;
+@property (nonatomic, assign) CGFloat rightLineSpacing;
+
+@end
+
+@implementation MGLineStyle
+
++ (MGLineStyle *)defaultStyle {
+  static MGLineStyle *style;
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    style = [[MGLineStyle alloc] init];
+    style.font = [UIFont fontWithName:@"HelveticaNeue-Light" size:16];
+    style.textColor = UIColor.blackColor;
+    style.textShadowColor = UIColor.clearColor;
+    style.leftTextShadowOffset = (CGSize){0, 1};
+    style.middleTextShadowOffset = (CGSize){0, 1};
+    style.rightTextShadowOffset = (CGSize){0, 1};
+    style.leftItemsAlignment = NSTextAlignmentLeft;
+    style.middleItemsAlignment = NSTextAlignmentCenter;
+    style.rightItemsAlignment = NSTextAlignmentRight;
+  });
+  return style;
+}
+
+#pragma mark - Copying
+
+- (id)copyWithZone:(NSZone *)zone {
+  if (self.class == MGLineStyle.class) { // immutable, so share it
+    return self;
+  }
+  return [self copyStyleTo:[[MGLineStyle allocWithZone:zone] init]];
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone {
+  return [self copyStyleTo:[[MGMutableLineStyle allocWithZone:zone] init]];
+}
+
+- (id)copyStyleTo:(MGLineStyle *)style {
+  style->_font = _font;
+  style->_middleFont = _middleFont;
+  style->_rightFont = _rightFont;
+  style->_textColor = _textColor;
+  style->_middleTextColor = _middleTextColor;
+  style->_rightTextColor = _rightTextColor;
+  style->_textShadowColor = _textShadowColor;
+  style->_middleTextShadowColor = _middleTextShadowColor;
+  style->_rightTextShadowColor = _rightTextShadowColor;
+  style->_leftTextShadowOffset = _leftTextShadowOffset;
+  style->_middleTextShadowOffset = _middleTextShadowOffset;
+  style->_rightTextShadowOffset = _rightTextShadowOffset;
+  style->_leftItemsAlignment = _leftItemsAlignment;
+  style->_middleItemsAlignment = _middleItemsAlignment;
+  style->_rightItemsAlignment = _rightItemsAlignment;
+  style->_leftLineSpacing = _leftLineSpacing;
+  style->_middleLineSpacing = _middleLineSpacing;
+  style->_rightLineSpacing = _rightLineSpacing;
+  return style;
+}
+
+#pragma mark - Column attributes
+
+- (UIFont *)fontFor:(MGItemPlacement)placement {
+  switch (placement) {
+    case MGMiddle:
+      return _middleFont ? : _font;
+    case MGRight:
+      return _rightFont ? : _font;
+    default:
+      return _font;
+  }
+}
+
+- (UIColor *)textColorFor:(MGItemPlacement)placement {
+  switch (placement) {
+    case MGMiddle:
+      return _middleTextColor ? : _textColor;
+    case MGRight:
+      return _rightTextColor ? : _textColor;
+    default:
+      return _textColor;
+  }
+}
+
+- (UIColor *)textShadowColorFor:(MGItemPlacement)placement {
+  switch (placement) {
+    case MGMiddle:
+      return _middleTextShadowColor ? : _textShadowColor;
+    case MGRight:
+      return _rightTextShadowColor ? : _textShadowColor;
+    default:
+      return _textShadowColor;
+  }
+}
+
+- (CGSize)textShadowOffsetFor:(MGItemPlacement)placement {
+  switch (placement) {
+    case MGMiddle:
+      return _middleTextShadowOffset;
+    case MGRight:
+      return _rightTextShadowOffset;
+    default:
+      return _leftTextShadowOffset;
+  }
+}
+
+- (NSTextAlignment)itemsAlignmentFor:(MGItemPlacement)placement {
+  switch (placement) {
+    case MGMiddle:
+      return _middleItemsAlignment;
+    case MGRight:
+      return _rightItemsAlignment;
+    default:
+      return _leftItemsAlignment;
+  }
+}
+
+- (CGFloat)lineSpacingFor:(MGItemPlacement)placement {
+  switch (placement) {
+    case MGMiddle:
+      return _middleLineSpacing;
+    case MGRight:
+      return _rightLineSpacing;
+    default:
+      return _leftLineSpacing;
+  }
+}
+
+@end
+
+@implementation MGMutableLineStyle
+
+@dynamic font, middleFont, rightFont;
+@dynamic textColor, middleTextColor, rightTextColor;
+@dynamic textShadowColor, middleTextShadowColor, rightTextShadowColor;
+@dynamic leftTextShadowOffset, middleTextShadowOffset, rightTextShadowOffset;
+@dynamic leftItemsAlignment, middleItemsAlignment, rightItemsAlignment;
+@dynamic leftLineSpacing, middleLineSpacing, rightLineSpacing;
+
+@end
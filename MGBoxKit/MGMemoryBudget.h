@@ -0,0 +1,99 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+/**
+* A rough estimate of the memory held by a view and its subviews: a fixed
+* overhead per view, plus the size of any bitmap layer contents.
+*/
+NSUInteger MGEstimatedCostOfView(UIView *view);
+
+/**
+* Implemented by caches that <MGMemoryBudget> can measure and trim.
+*/
+@protocol MGTrimmableCache <NSObject>
+
+/** A short name for usage reports, eg "MGBoxReusePool". */
+- (NSString *)cacheName;
+
+/** The approximate number of bytes held by the cache. */
+- (NSUInteger)cacheCost;
+
+/** Drops cached content until the cache's cost is at or under `cost`. */
+- (void)trimToCost:(NSUInteger)cost;
+
+@optional
+
+/**
+* Bytes held that can't be trimmed, eg a provider's current frames. Shown in
+* <[MGMemoryBudget usage]>, but not counted against the budget, so that a
+* cache that can't shrink doesn't make the others give up everything.
+*/
+- (NSUInteger)pinnedCost;
+
+@end
+
+/**
+A single memory budget shared by all of MGBoxKit's caches (box reuse pools,
+offscreen frames for nested providers, rendered bitmaps, colour lookups).
+
+Caches register themselves when created. When their combined cost goes over
+<totalBudget>, each is trimmed in proportion to its share. All caches are
+emptied on memory warnings, and trimmed to <backgroundBudget> when the app
+enters the background.
+
+    MGMemoryBudget.sharedBudget.totalBudget = 16 * 1024 * 1024;
+    NSLog(@"%@", MGMemoryBudget.sharedBudget.usage);
+*/
+
+@interface MGMemoryBudget : NSObject
+
++ (instancetype)sharedBudget;
+
+/** @name Limits */
+
+/** The most bytes all registered caches may hold together. Default is 32MB. */
+@property (nonatomic, assign) NSUInteger totalBudget;
+
+/** The budget applied when the app enters the background. Default is 4MB. */
+@property (nonatomic, assign) NSUInteger backgroundBudget;
+
+/** @name Caches */
+
+/**
+* Adds a cache to the budget. Caches are held weakly, so there's no need to
+* unregister them on dealloc.
+*/
+- (void)registerCache:(id <MGTrimmableCache>)cache;
+- (void)unregisterCache:(id <MGTrimmableCache>)cache;
+
+/**
+* Caches should call this after growing, from any thread. If the budget is
+* exceeded, all caches are trimmed on the main queue. Checks are coalesced, so
+* this is cheap enough to call often.
+*/
+- (void)cacheDidGrow:(id <MGTrimmableCache>)cache;
+
+/** @name Usage */
+
+/**
+* The current cost in bytes of each cache name, summed over caches sharing a
+* name (eg every provider's reuse pool). Pinned costs are listed separately,
+* as eg "MGBoxProvider (pinned)".
+*/
+- (NSDictionary *)usage;
+
+/** The current trimmable cost in bytes of all registered caches. */
+- (NSUInteger)totalCost;
+
+/** @name Trimming */
+
+/**
+* Trims every cache in proportion to its cost, so that their total is at or
+* under `cost`. Pass 0 to empty all caches. Must be called on the main thread.
+*/
+- (void)trimToCost:(NSUInteger)cost;
+
+@end
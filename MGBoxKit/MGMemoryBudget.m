@@ -0,0 +1,150 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGMemoryBudget.h"
+
+// rough overhead of a view and its layer, without any backing store
+#define VIEW_OVERHEAD 1024
+
+NSUInteger MGEstimatedCostOfView(UIView *view) {
+    NSUInteger cost = VIEW_OVERHEAD;
+    id contents = view.layer.contents;
+    if (contents && CFGetTypeID((__bridge CFTypeRef)contents) == CGImageGetTypeID()) {
+        CGImageRef image = (__bridge CGImageRef)contents;
+        cost += CGImageGetBytesPerRow(image) * CGImageGetHeight(image);
+    }
+    for (UIView *subview in view.subviews) {
+        cost += MGEstimatedCostOfView(subview);
+    }
+    return cost;
+}
+
+@implementation MGMemoryBudget {
+    NSHashTable *_caches;
+    BOOL _trimming, _checkQueued;
+}
+
++ (instancetype)sharedBudget {
+    static MGMemoryBudget *budget;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        budget = self.new;
+    });
+    return budget;
+}
+
+- (id)init {
+    self = [super init];
+    _caches = NSHashTable.weakObjectsHashTable;
+    self.totalBudget = 32 * 1024 * 1024;
+    self.backgroundBudget = 4 * 1024 * 1024;
+
+    [NSNotificationCenter.defaultCenter addObserver:self
+          selector:@selector(didReceiveMemoryWarning:)
+          name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+    [NSNotificationCenter.defaultCenter addObserver:self
+          selector:@selector(didEnterBackground:)
+          name:UIApplicationDidEnterBackgroundNotification object:nil];
+    return self;
+}
+
+#pragma mark - Caches
+
+- (void)registerCache:(id <MGTrimmableCache>)cache {
+    @synchronized (self) {
+        [_caches addObject:cache];
+    }
+}
+
+- (void)unregisterCache:(id <MGTrimmableCache>)cache {
+    @synchronized (self) {
+        [_caches removeObject:cache];
+    }
+}
+
+- (NSArray *)allCaches {
+    @synchronized (self) {
+        return _caches.allObjects;
+    }
+}
+
+- (void)cacheDidGrow:(id <MGTrimmableCache>)cache {
+
+    // caches can grow on any thread, but pooled views must be trimmed on main
+    @synchronized (self) {
+        if (_checkQueued) {
+            return;
+        }
+        _checkQueued = YES;
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+        @synchronized (self) {
+            self->_checkQueued = NO;
+        }
+        if (self.totalCost > self.totalBudget) {
+            [self trimToCost:self.totalBudget];
+        }
+    });
+}
+
+#pragma mark - Usage
+
+- (NSDictionary *)usage {
+    NSMutableDictionary *usage = @{}.mutableCopy;
+    for (id <MGTrimmableCache> cache in self.allCaches) {
+        NSString *name = cache.cacheName;
+        usage[name] = @([usage[name] unsignedIntegerValue] + cache.cacheCost);
+        if ([cache respondsToSelector:@selector(pinnedCost)]) {
+            NSString *pinned = [name stringByAppendingString:@" (pinned)"];
+            usage[pinned] = @([usage[pinned] unsignedIntegerValue] + cache.pinnedCost);
+        }
+    }
+    return usage;
+}
+
+- (NSUInteger)totalCost {
+    NSUInteger total = 0;
+    for (id <MGTrimmableCache> cache in self.allCaches) {
+        total += cache.cacheCost;
+    }
+    return total;
+}
+
+#pragma mark - Trimming
+
+- (void)trimToCost:(NSUInteger)cost {
+    NSAssert(NSThread.isMainThread, @"Caches must be trimmed on the main thread");
+    if (_trimming) {
+        return;
+    }
+    _trimming = YES;
+    NSArray *caches = self.allCaches;
+    NSUInteger total = 0;
+    for (id <MGTrimmableCache> cache in caches) {
+        total += cache.cacheCost;
+    }
+    if (total > cost) {
+        double ratio = total ? (double)cost / total : 0;
+        for (id <MGTrimmableCache> cache in caches) {
+            [cache trimToCost:(NSUInteger)(cache.cacheCost * ratio)];
+        }
+    }
+    _trimming = NO;
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)note {
+    [self trimToCost:0];
+}
+
+- (void)didEnterBackground:(NSNotification *)note {
+    [self trimToCost:self.backgroundBudget];
+}
+
+#pragma mark - Fini
+
+- (void)dealloc {
+    [NSNotificationCenter.defaultCenter removeObserver:self];
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+@class MGScrollView;
+
+/**
+A small debug overlay showing what a scroller is doing, read from the counters
+that the box provider, its reuse pool, and <MGAsyncLayoutScheduler> already
+keep:
+
+- frame rate, and the longest frame, over the last quarter second
+- the last layout pass's total and per stage times (see
+  [lastLayoutTimings](-[MGBoxProvider lastLayoutTimings]))
+- visible index, live box, and pooled box counts
+- reuse pool hit rate per box type
+- pending and running `asyncLayout` work
+
+Usually turned on with
+[showsPerformanceHUD](-[MGScrollView showsPerformanceHUD]), which places the
+HUD over the scroller's top left corner.
+
+    self.scroller.showsPerformanceHUD = YES;
+
+The HUD only runs its display link while it's in a window, and nothing is
+measured for it beyond the counters kept anyway, so there's no cost while it's
+off.
+*/
+
+@interface MGPerformanceHUD : UIView
+
++ (instancetype)hudForScroller:(MGScrollView *)scroller;
+
+@property (nonatomic, weak, readonly) MGScrollView *scroller;
+
+/** How often the text is refreshed, in seconds. Default is 0.25. */
+@property (nonatomic, assign) NSTimeInterval refreshInterval;
+
+@end
@@ -0,0 +1,143 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGPerformanceHUD.h"
+#import "MGScrollView.h"
+#import "MGBoxProvider.h"
+#import "MGBoxReusePool.h"
+#import "MGAsyncLayoutScheduler.h"
+
+// padding inside the HUD, and its gap from the scroller's corner
+#define HUD_INSET 4
+
+@implementation MGPerformanceHUD {
+    UILabel *_label;
+    CADisplayLink *_displayLink;
+    CFTimeInterval _lastTick, _lastRefresh, _longestFrame;
+    NSUInteger _frames;
+}
+
++ (instancetype)hudForScroller:(MGScrollView *)scroller {
+    MGPerformanceHUD *hud = [[self alloc] initWithFrame:CGRectZero];
+    hud->_scroller = scroller;
+    return hud;
+}
+
+- (id)initWithFrame:(CGRect)frame {
+    self = [super initWithFrame:frame];
+    self.userInteractionEnabled = NO;
+    self.backgroundColor = [UIColor colorWithWhite:0 alpha:0.7];
+    self.layer.cornerRadius = HUD_INSET;
+    self.refreshInterval = 0.25;
+
+    _label = [[UILabel alloc] initWithFrame:CGRectZero];
+    _label.font = [UIFont fontWithName:@"Menlo-Regular" size:10];
+    _label.textColor = UIColor.whiteColor;
+    _label.numberOfLines = 0;
+    [self addSubview:_label];
+
+    return self;
+}
+
+#pragma mark - Display link
+
+- (void)didMoveToWindow {
+    [super didMoveToWindow];
+
+    // the display link retains the HUD, so it only runs while on screen
+    if (self.window && !_displayLink) {
+        _lastTick = 0;
+        _displayLink = [CADisplayLink displayLinkWithTarget:self
+              selector:@selector(tick:)];
+        [_displayLink addToRunLoop:NSRunLoop.mainRunLoop forMode:NSRunLoopCommonModes];
+    } else if (!self.window) {
+        [_displayLink invalidate];
+        _displayLink = nil;
+    }
+}
+
+- (void)tick:(CADisplayLink *)link {
+    if (!self.scroller) {
+        [self removeFromSuperview];
+        return;
+    }
+
+    CFTimeInterval now = link.timestamp;
+    if (_lastTick) {
+        _longestFrame = MAX(_longestFrame, now - _lastTick);
+        _frames++;
+    } else {
+        _lastRefresh = now;
+        _longestFrame = 0;
+        _frames = 0;
+    }
+    _lastTick = now;
+
+    if (now - _lastRefresh < self.refreshInterval) {
+        return;
+    }
+    [self refreshWithFrameRate:_frames / (now - _lastRefresh)];
+    _lastRefresh = now;
+    _longestFrame = 0;
+    _frames = 0;
+}
+
+#pragma mark - Refreshing
+
+- (void)refreshWithFrameRate:(double)frameRate {
+    MGScrollView *scroller = self.scroller;
+    MGBoxProvider *provider = scroller.boxProvider;
+    MGAsyncLayoutScheduler *scheduler = MGAsyncLayoutScheduler.sharedScheduler;
+
+    NSMutableString *text = [NSMutableString stringWithFormat:
+          @"%.0f fps, longest %.1f ms", frameRate, _longestFrame * 1000];
+
+    if (provider) {
+        MGLayoutTimings timings = provider.lastLayoutTimings;
+        [text appendFormat:@"\nlayout %.2f ms", timings.total * 1000];
+        [text appendFormat:@"\n keys %.2f frames %.2f", timings.dataKeys * 1000,
+              timings.boxFrames * 1000];
+        [text appendFormat:@"\n visible %.2f boxes %.2f",
+              timings.visibleIndexes * 1000, timings.boxes * 1000];
+        [text appendFormat:@"\nvisible %lu live %lu pooled %lu",
+              (unsigned long)provider.visibleIndexes.count,
+              (unsigned long)provider.liveBoxCount,
+              (unsigned long)provider.pooledBoxCount];
+
+        NSDictionary *hitRates = provider.reusePool.hitRates;
+        NSArray *types = [hitRates.allKeys sortedArrayUsingSelector:@selector(compare:)];
+        for (NSString *type in types) {
+            [text appendFormat:@"\nreuse %@ %.0f%%", type,
+                  [hitRates[type] doubleValue] * 100];
+        }
+    } else {
+        [text appendFormat:@"\nboxes %lu", (unsigned long)scroller.boxes.count];
+    }
+
+    [text appendFormat:@"\nasync pending %lu running %lu",
+          (unsigned long)scheduler.pendingCount, (unsigned long)scheduler.runningCount];
+
+    _label.text = text;
+    [self positionOverScroller];
+}
+
+- (void)positionOverScroller {
+    MGScrollView *scroller = self.scroller;
+    UIView *superview = self.superview;
+    if (!superview) {
+        return;
+    }
+
+    CGSize size = [_label sizeThatFits:(CGSize){CGFLOAT_MAX, CGFLOAT_MAX}];
+    _label.frame = (CGRect){HUD_INSET, HUD_INSET, size};
+
+    CGPoint corner = [scroller convertPoint:scroller.bounds.origin toView:superview];
+    self.frame = (CGRect){
+        corner.x + HUD_INSET, corner.y + HUD_INSET,
+        size.width + HUD_INSET * 2, size.height + HUD_INSET * 2
+    };
+    [superview bringSubviewToFront:self];
+}
+
+@end
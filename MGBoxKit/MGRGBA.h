@@ -0,0 +1,136 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import <UIKit/UIKit.h>
+#import <simd/simd.h>
+
+/**
+* A colour as a plain value: red, green, blue, and alpha in the `x`, `y`, `z`,
+* and `w` lanes of a SIMD vector, so that most operations compile to a few
+* vector instructions. Palettes and gradients can be built and transformed in
+* C arrays, then turned into `UIColor`s only when handed to UIKit, with
+* [UIColor colorWithRGBA:] or [UIColor colorsWithRGBA:count:].
+
+    MGRGBA stripes[2] = {MGRGBAFromHex(0xf5f5f5), MGRGBAFromHex(0xe8e8e8)};
+    MGRGBAMultiplyAll(stripes, stripes, 2, MGRGBAMake(1, 0.95, 0.9, 1));
+    box.backgroundColor = [UIColor colorWithRGBA:stripes[index % 2]];
+
+Components are floats, nominally 0 to 1. The operations below clamp their
+results to that range, except lightening and darkening, which only pick
+between existing values.
+*/
+typedef vector_float4 MGRGBA;
+
+#pragma mark - Making
+
+static inline MGRGBA MGRGBAMake(float red, float green, float blue,
+      float alpha) {
+    return (MGRGBA){red, green, blue, alpha};
+}
+
+static inline MGRGBA MGRGBAWhite(float white, float alpha) {
+    return (MGRGBA){white, white, white, alpha};
+}
+
+/** From a 24 bit `0xrrggbb` value, fully opaque. */
+static inline MGRGBA MGRGBAFromHex(UInt32 hex) {
+    return (MGRGBA){(hex >> 16) & 0xFF, (hex >> 8) & 0xFF, hex & 0xFF, 255}
+          / 255.0f;
+}
+
+#pragma mark - Arithmetic
+
+static inline MGRGBA MGRGBAClamp(MGRGBA color) {
+    return vector_clamp(color, (MGRGBA)0, (MGRGBA)1);
+}
+
+/** Each component multiplied by the same component of `by`. */
+static inline MGRGBA MGRGBAMultiply(MGRGBA color, MGRGBA by) {
+    return MGRGBAClamp(color * by);
+}
+
+/** The colour components multiplied by `f`, leaving alpha unchanged. */
+static inline MGRGBA MGRGBAScale(MGRGBA color, float f) {
+    return MGRGBAClamp(color * (MGRGBA){f, f, f, 1});
+}
+
+static inline MGRGBA MGRGBAAdd(MGRGBA color, MGRGBA add) {
+    return MGRGBAClamp(color + add);
+}
+
+/** The greater of each component. */
+static inline MGRGBA MGRGBALighten(MGRGBA color, MGRGBA to) {
+    return vector_max(color, to);
+}
+
+/** The lesser of each component. */
+static inline MGRGBA MGRGBADarken(MGRGBA color, MGRGBA to) {
+    return vector_min(color, to);
+}
+
+/** Linear interpolation, `t` from 0 (`from`) to 1 (`to`). */
+static inline MGRGBA MGRGBAMix(MGRGBA from, MGRGBA to, float t) {
+    return vector_mix(from, to, (MGRGBA)t);
+}
+
+/**
+* Rec. 709 luma (`0.2126 R + 0.7152 G + 0.0722 B`), as used by
+* [UIColor colorByLuminanceMapping].
+*/
+static inline float MGRGBALuminance(MGRGBA color) {
+    return vector_dot(color, (MGRGBA){0.2126f, 0.7152f, 0.0722f, 0});
+}
+
+/** The grey of the same luminance, keeping alpha. */
+static inline MGRGBA MGRGBALuminanceMapped(MGRGBA color) {
+    float y = MGRGBALuminance(color);
+    return (MGRGBA){y, y, y, color.w};
+}
+
+static inline BOOL MGRGBAEqual(MGRGBA a, MGRGBA b) {
+    return vector_all(a == b);
+}
+
+#pragma mark - Hue, saturation, brightness
+
+/**
+* Hue, saturation, brightness, and alpha in the `x`, `y`, `z`, and `w` lanes,
+* matching [UIColor colorWithHue:saturation:brightness:alpha:].
+*/
+MGRGBA MGRGBAToHSB(MGRGBA color);
+MGRGBA MGRGBAFromHSB(MGRGBA hsba);
+
+/**
+* Adds to the colour's hue, saturation, brightness, and alpha, clamping each,
+* as [UIColor colorByAddingHue:saturation:brightness:alpha:] does.
+*/
+MGRGBA MGRGBAAddHSB(MGRGBA color, MGRGBA hsba);
+
+#pragma mark - Bulk operations
+
+/**
+* The bulk operations read `count` colours from `colors` and write the results
+* to `results`, which may be the same array.
+*/
+void MGRGBAMultiplyAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA by);
+void MGRGBAAddAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA add);
+void MGRGBALightenAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA to);
+void MGRGBADarkenAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA to);
+void MGRGBAAddHSBAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA hsba);
+void MGRGBALuminanceMapAll(const MGRGBA *colors, MGRGBA *results,
+      NSUInteger count);
+
+/** The luminance of each colour, written to `luminances`. */
+void MGRGBALuminances(const MGRGBA *colors, float *luminances, NSUInteger count);
+
+/**
+* Fills `results` with `count` colours evenly spaced from `from` to `to`
+* inclusive, eg for striping the rows of a table.
+*/
+void MGRGBAGradient(MGRGBA from, MGRGBA to, MGRGBA *results, NSUInteger count);
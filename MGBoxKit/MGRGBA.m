@@ -0,0 +1,105 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGRGBA.h"
+
+#pragma mark - Hue, saturation, brightness
+
+MGRGBA MGRGBAToHSB(MGRGBA color) {
+    float max = MAX(color.x, MAX(color.y, color.z));
+    float min = MIN(color.x, MIN(color.y, color.z));
+    float delta = max - min;
+
+    float hue = 0;
+    if (delta > 0) {
+        if (max == color.x) {
+            hue = (color.y - color.z) / delta;
+        } else if (max == color.y) {
+            hue = (color.z - color.x) / delta + 2;
+        } else {
+            hue = (color.x - color.y) / delta + 4;
+        }
+        hue /= 6;
+        if (hue < 0) {
+            hue += 1;
+        }
+    }
+
+    return (MGRGBA){hue, max > 0 ? delta / max : 0, max, color.w};
+}
+
+// f(n) = V - VS * clamp(min(k, 4 - k)), where k = (n + 6H) mod 6, with n of
+// 5, 3, and 1 for red, green, and blue, all three lanes at once
+MGRGBA MGRGBAFromHSB(MGRGBA hsba) {
+    vector_float3 k = 6 * vector_fract(((vector_float3){5, 3, 1} + hsba.x * 6) / 6);
+    vector_float3 x = vector_clamp(vector_min(k, 4 - k), (vector_float3)0,
+          (vector_float3)1);
+    vector_float3 rgb = hsba.z - hsba.z * hsba.y * x;
+    return (MGRGBA){rgb.x, rgb.y, rgb.z, hsba.w};
+}
+
+MGRGBA MGRGBAAddHSB(MGRGBA color, MGRGBA hsba) {
+    return MGRGBAFromHSB(MGRGBAClamp(MGRGBAToHSB(color) + hsba));
+}
+
+#pragma mark - Bulk operations
+
+void MGRGBAMultiplyAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA by) {
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBAMultiply(colors[i], by);
+    }
+}
+
+void MGRGBAAddAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA add) {
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBAAdd(colors[i], add);
+    }
+}
+
+void MGRGBALightenAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA to) {
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBALighten(colors[i], to);
+    }
+}
+
+void MGRGBADarkenAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA to) {
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBADarken(colors[i], to);
+    }
+}
+
+void MGRGBAAddHSBAll(const MGRGBA *colors, MGRGBA *results, NSUInteger count,
+      MGRGBA hsba) {
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBAAddHSB(colors[i], hsba);
+    }
+}
+
+void MGRGBALuminanceMapAll(const MGRGBA *colors, MGRGBA *results,
+      NSUInteger count) {
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBALuminanceMapped(colors[i]);
+    }
+}
+
+void MGRGBALuminances(const MGRGBA *colors, float *luminances, NSUInteger count) {
+    for (NSUInteger i = 0; i < count; i++) {
+        luminances[i] = MGRGBALuminance(colors[i]);
+    }
+}
+
+void MGRGBAGradient(MGRGBA from, MGRGBA to, MGRGBA *results, NSUInteger count) {
+    if (count == 1) {
+        results[0] = from;
+        return;
+    }
+    float step = 1.0f / (count - 1);
+    for (NSUInteger i = 0; i < count; i++) {
+        results[i] = MGRGBAMix(from, to, i * step);
+    }
+}
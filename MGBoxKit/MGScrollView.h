@@ -6,6 +6,10 @@
 #import <Foundation/Foundation.h>
 #import "MGLayoutBox.h"
 
+typedef enum {
+  MGSnapLeadingEdge, MGSnapCenter, MGSnapPage
+} MGSnapMode;
+
 @interface MGScrollView : UIScrollView
     <MGLayoutBox, UIGestureRecognizerDelegate, UIScrollViewDelegate>
 
@@ -53,6 +57,21 @@
 */
 - (void)layoutWithDuration:(NSTimeInterval)duration completion:(MGBlock)completion;
 
+/**
+Lays out only the items appended to the end of a
+[boxProvider](-[MGLayoutBox boxProvider])'s data since the last layout, without
+recomputing keys or frames for the existing items. Useful for infinite feeds,
+especially in `MGLayoutMasonryStyle`, where appended boxes continue to fill the
+shortest columns.
+
+    [self.items addObjectsFromArray:nextPage];
+    [self.scroller layoutAppendedBoxes];
+
+@warning Only use this when items have been appended. For any other data
+changes, use <layout> or <layoutWithDuration:completion:>.
+*/
+- (void)layoutAppendedBoxes;
+
 /** @name Scrolling */
 
 /**
@@ -66,16 +85,28 @@
 
 /**
  * Called to save the scroll view offset at the current time.
- * Most commonly called in willRotateToInterfaceOrientation
+ * Most commonly called in willRotateToInterfaceOrientation.
+ * The first box reaching into the viewport is remembered as the anchor (by
+ * data key, when using a [boxProvider](-[MGLayoutBox boxProvider])).
  */
 - (void)saveScrollOffset;
 
 /**
  * Called to restore the previously stored scroll offset.
- * Most commonly called in willAnimateRotationToInterfaceOrientation after a call to layout
+ * Most commonly called in willAnimateRotationToInterfaceOrientation.
+ * The anchor box is kept at the same distance from the top of the viewport.
+ * Box provider frames are only restacked as far as the anchor and a screenful
+ * past it, with the rest stacked over the following run loop passes, so there's
+ * no need to call layout first. Reusable boxes are kept.
  */
 - (void)restoreScrollOffset;
 
+/**
+* The current scroll velocity in points per second, smoothed over recent
+* scroll events. Zero when not scrolling.
+*/
+@property (nonatomic, readonly) CGPoint scrollVelocity;
+
 /** @name Box adding and removing */
 
 /**
@@ -85,14 +116,49 @@
 */
 @property (nonatomic, assign) CGSize viewportMargin;
 
+/**
+* If set to YES, the <viewportMargin> adapts to scrolling. Ahead of the scroll
+* direction it grows with the <scrollVelocity>, to cover roughly the next 0.25
+* seconds of travel, up to <maxViewportMargin>. Behind it shrinks as speed
+* increases, and when idle it returns to <viewportMargin> on all sides. This
+* keeps few boxes live while at rest, without boxes being made just in time
+* during flings. Default is `NO`.
+*/
+@property (nonatomic, assign) BOOL adaptiveViewportMargin;
+
+/**
+* The most an <adaptiveViewportMargin> can grow to in each direction. The
+* default of `CGSizeZero` caps it at the scroller's own size.
+*/
+@property (nonatomic, assign) CGSize maxViewportMargin;
+
 /** @name Box edge snapping */
 
 /**
 * Toggle on or off box edge snapping, to create an effect similar to
 * `UIScrollView` paging, but that is aware of individual child box edges.
+* Works with both [boxes](-[MGLayoutBox boxes]) and a
+* [boxProvider](-[MGLayoutBox boxProvider]). The snap target is chosen when
+* dragging ends, so deceleration lands on it directly.
 */
 @property (nonatomic, assign) BOOL snapToBoxEdges;
 
+/**
+* Where to snap to when <snapToBoxEdges> is on. `MGSnapLeadingEdge` (the
+* default) snaps the nearest box's top edge to the top of the scroller.
+* `MGSnapCenter` snaps the nearest box's centre to the scroller's centre.
+* `MGSnapPage` moves a page of <snapPageSize> rows at a time, in the direction
+* of the drag.
+*/
+@property (nonatomic, assign) MGSnapMode snapMode;
+
+/**
+* The number of rows in a page when <snapMode> is `MGSnapPage`. Rows are
+* counted by the boxes sharing the first box's top edge, so a page of a grid
+* covers whole rows. Default is 1.
+*/
+@property (nonatomic, assign) NSUInteger snapPageSize;
+
 // this doesn't need to be public now. might go private in a future release
 - (void)snapToNearestBox;
 
@@ -116,6 +182,44 @@
  */
 @property (nonatomic, assign) BOOL allowTouchesToPassThrough;
 
+/** @name Gesture dispatch */
+
+/**
+* If set to YES, the scroller owns a single tap, long press, and set of swipe
+* recognisers, and dispatches gestures to the tappable, long pressable, or
+* swipable child box under the touch, instead of each child box attaching its
+* own. The target box is found through the box provider's frame index, or from
+* [boxes](-[MGLayoutBox boxes]) without a provider. Default is `NO`.
+*
+* Box highlighting works as before. Long presses call
+* [longPressed](-[MGLayoutBox longPressed]) once, when the press begins, and
+* keep the box highlighted until it ends. Swipes are dispatched for the
+* directions set on each box's [swiper](-[MGLayoutBox swiper]).
+*/
+@property (nonatomic, assign) BOOL dispatchesBoxGestures;
+
+/**
+* The child box whose frame contains the given point (in the scroller's
+* coordinates, ie including the content offset), or `nil`.
+*/
+- (UIView <MGLayoutBox> *)boxAtPoint:(CGPoint)point;
+
+/**
+* Call after moving, resizing, or hiding subviews outside of a layout pass, so
+* that hit testing sees the change. `MGBox` subviews call it themselves when
+* their frame or hidden state changes.
+*/
+- (void)subviewFramesDidChange;
+
+/** @name Debugging */
+
+/**
+* Shows an <MGPerformanceHUD> over the scroller's top left corner, with the
+* frame rate, layout stage times, box counts, reuse hit rates, and pending
+* async layouts. The HUD is added to the scroller's superview. Default is `NO`.
+*/
+@property (nonatomic, assign) BOOL showsPerformanceHUD;
+
 - (void)keyboardWillAppear:(NSNotification *)note;
 
 @end
@@ -6,20 +6,48 @@
 
 #import "MGScrollView.h"
 #import "MGLayoutManager.h"
+#import "MGAsyncLayoutScheduler.h"
 #import "MGBoxProvider.h"
+#import "MGBoxFrameIndex.h"
+#import "MGBox.h"
+#import "MGSpatialGrid.h"
+#import "MGPerformanceHUD.h"
 
 // default keyboardMargin
 #define KEYBOARD_MARGIN 8
 
+// seconds of travel the adaptive viewport margin covers ahead
+#define ADAPTIVE_LEAD_TIME 0.25
+
+// speed at which the adaptive margin behind is halved, in points per second
+#define ADAPTIVE_TRAIL_SPEED 1000
+
+// how many frames past a binary search hit to check for a nearer snap edge
+#define SNAP_SCAN_LIMIT 64
+
+// hit testing grid cell size
+#define HIT_GRID_CELL_SIZE 128
+
 @implementation MGScrollView {
     CGFloat keyboardNudge;
     BOOL fixedPositionEstablished;
-    BOOL asyncDrawing, asyncDrawOnceing;
     CGRect keyboardFrame;
     CGRect _previousFrame;
     CGSize _previousContentSize;
     CGPoint _previousContentOffset;
     UIEdgeInsets _previousContentInset;
+    id _anchorKey;
+    __weak UIView *_anchorBox;
+    CGFloat _anchorTop;
+    UITapGestureRecognizer *boxTapper;
+    UILongPressGestureRecognizer *boxLongPresser;
+    NSArray *boxSwipers;
+    __weak UIView <MGLayoutBox> *longPressedBox;
+    MGSpatialGrid *hitGrid;
+    NSArray *floatingSubviews;
+    CFTimeInterval lastScrollTime;
+    CGPoint lastScrollOffset;
+    MGPerformanceHUD *performanceHUD;
 }
 
 // MGLayoutBox protocol
@@ -68,6 +96,7 @@
   // defaults
   self.keyboardMargin = KEYBOARD_MARGIN;
   self.keepFirstResponderAboveKeyboard = YES;
+  self.snapPageSize = 1;
     self.sizingMode = MGResizingShrinkWrap;
 
   self.delegate = self;
@@ -85,27 +114,24 @@
 
 - (void)layout {
   [MGLayoutManager layoutBoxesIn:self];
+  hitGrid = nil;
 
   // async draws
-  if (self.asyncLayout || self.asyncLayoutOnce) {
-    dispatch_async(self.asyncQueue, ^{
-        if (self.asyncLayout && !self->asyncDrawing) {
-            self->asyncDrawing = YES;
-            self.asyncLayout();
-            self->asyncDrawing = NO;
-        }
-        if (self.asyncLayoutOnce && !self->asyncDrawOnceing) {
-            self->asyncDrawOnceing = YES;
-            self.asyncLayoutOnce();
-            self.asyncLayoutOnce = nil;
-            self->asyncDrawOnceing = NO;
-        }
-    });
-  }
+  [MGAsyncLayoutScheduler.sharedScheduler scheduleLayoutFor:self];
 }
 
 - (void)layoutWithDuration:(NSTimeInterval)duration completion:(MGBlock)completion {
     [MGLayoutManager layoutBoxesIn:self duration:duration completion:completion];
+    hitGrid = nil;
+}
+
+- (void)layoutAppendedBoxes {
+    if (!self.boxProvider) {
+        [self layout];
+        return;
+    }
+    [MGLayoutManager layoutAppendedBoxesIn:self];
+    hitGrid = nil;
 }
 
 - (void)layoutSubviews {
@@ -120,6 +146,16 @@
   }
 }
 
+- (void)didAddSubview:(UIView *)subview {
+  [super didAddSubview:subview];
+  hitGrid = nil;
+}
+
+- (void)willRemoveSubview:(UIView *)subview {
+  [super willRemoveSubview:subview];
+  hitGrid = nil;
+}
+
 - (void)appeared {
     if (self.onAppear) {
         self.onAppear();
@@ -153,17 +189,168 @@
   return ![touch.view isKindOfClass:UIControl.class];
 }
 
+- (BOOL)gestureRecognizerShouldBegin:(UIGestureRecognizer *)recogniser {
+  if (recogniser == boxTapper || recogniser == boxLongPresser
+      || [boxSwipers containsObject:recogniser]) {
+    return [self boxForGesture:recogniser] != nil;
+  }
+  return [super gestureRecognizerShouldBegin:recogniser];
+}
+
+#pragma mark - Gesture dispatch
+
+- (void)setDispatchesBoxGestures:(BOOL)dispatches {
+  if (_dispatchesBoxGestures == dispatches) {
+    return;
+  }
+  _dispatchesBoxGestures = dispatches;
+
+  NSMutableArray *recognisers = @[self.boxTapper, self.boxLongPresser].mutableCopy;
+  [recognisers addObjectsFromArray:self.boxSwipers];
+  for (UIGestureRecognizer *recogniser in recognisers) {
+    if (dispatches) {
+      [self addGestureRecognizer:recogniser];
+    } else {
+      [self removeGestureRecognizer:recogniser];
+    }
+  }
+
+  // boxes attach or detach their own recognisers
+  for (MGBox *box in self.subviews) {
+    if ([box isKindOfClass:MGBox.class]) {
+      [box updateGestureRecognizers];
+    }
+  }
+}
+
+- (UIView <MGLayoutBox> *)boxAtPoint:(CGPoint)point {
+
+  // no frames before the first layout, or after a discarded layout cache
+  if (self.boxProvider.boxFrames) {
+    NSUInteger index = [self.boxProvider.boxFrames indexOfFrameContainingPoint:point];
+    return index == NSNotFound ? nil : self.boxProvider.visibleBoxes[@(index)];
+  }
+  UIView *view = [self subviewAtPoint:point];
+  return [view conformsToProtocol:@protocol(MGLayoutBox)] ? (id)view : nil;
+}
+
+- (UIView <MGLayoutBox> *)boxForGesture:(UIGestureRecognizer *)recogniser {
+  UIView <MGLayoutBox> *box = [self boxAtPoint:[recogniser locationInView:self]];
+  if (!box) {
+    return nil;
+  }
+  if (recogniser == boxTapper) {
+    return [box respondsToSelector:@selector(tappable)] && box.tappable ? box : nil;
+  }
+  if (recogniser == boxLongPresser) {
+    return [box respondsToSelector:@selector(longPressable)] && box.longPressable ? box : nil;
+  }
+  if (![box respondsToSelector:@selector(swipable)] || !box.swipable) {
+    return nil;
+  }
+  UISwipeGestureRecognizerDirection direction = [(id)recogniser direction];
+  return box.swiper.direction & direction ? box : nil;
+}
+
+- (void)boxTapped:(UITapGestureRecognizer *)recogniser {
+  UIView <MGLayoutBox> *box = [self boxForGesture:recogniser];
+  if (box) {
+    [box tapped];
+  }
+}
+
+- (void)boxSwiped:(UISwipeGestureRecognizer *)recogniser {
+  UIView <MGLayoutBox> *box = [self boxForGesture:recogniser];
+  if (box) {
+    [box swiped];
+  }
+}
+
+- (void)boxLongPressed:(UILongPressGestureRecognizer *)recogniser {
+  switch (recogniser.state) {
+    case UIGestureRecognizerStateBegan: {
+      UIView <MGLayoutBox> *box = [self boxForGesture:recogniser];
+      if ([box isKindOfClass:MGBox.class]) {
+        [(MGBox *)box setHighlighted:YES];
+      }
+      longPressedBox = box;
+      [box longPressed];
+      break;
+    }
+    case UIGestureRecognizerStateEnded:
+    case UIGestureRecognizerStateCancelled:
+    case UIGestureRecognizerStateFailed:
+      if ([longPressedBox isKindOfClass:MGBox.class]) {
+        [(MGBox *)longPressedBox setHighlighted:NO];
+      }
+      longPressedBox = nil;
+      break;
+    default:
+      break;
+  }
+}
+
 - (BOOL)pointInside:(CGPoint)point withEvent:(UIEvent *)event {
-    if (self.allowTouchesToPassThrough) {
-        for (UIView *view in self.subviews) {
-            if (CGRectContainsPoint(view.frame, point)) {
-                return [super pointInside:point withEvent:event];
-            }
-        }
+    if (![super pointInside:point withEvent:event]) {
         return NO;
-    } else {
-        return [super pointInside:point withEvent:event];
     }
+    if (!self.allowTouchesToPassThrough) {
+        return YES;
+    }
+
+    // no frames before the first layout, or after a discarded layout cache
+    MGBoxFrameIndex *frames = self.boxProvider.boxFrames;
+    if (frames && [frames indexOfFrameContainingPoint:point] != NSNotFound) {
+        return YES;
+    }
+    return [self subviewAtPoint:point] != nil;
+}
+
+#pragma mark - Hit testing
+
+- (UIView *)subviewAtPoint:(CGPoint)point {
+    if (!hitGrid) {
+        [self buildHitGrid];
+    }
+
+    // fixed position boxes move with the content offset, so aren't in the grid
+    for (UIView *view in floatingSubviews.reverseObjectEnumerator) {
+        if (!view.hidden && CGRectContainsPoint(view.frame, point)) {
+            return view;
+        }
+    }
+
+    // the grid only narrows it down. live frames have the final say
+    for (UIView *view in [hitGrid objectsAtPoint:point].reverseObjectEnumerator) {
+        if (!view.hidden && CGRectContainsPoint(view.frame, point)) {
+            return view;
+        }
+    }
+    return nil;
+}
+
+- (void)subviewFramesDidChange {
+    hitGrid = nil;
+}
+
+- (void)buildHitGrid {
+    hitGrid = [MGSpatialGrid gridWithCellSize:CGSizeMake(HIT_GRID_CELL_SIZE,
+          HIT_GRID_CELL_SIZE)];
+    NSMutableArray *floating = @[].mutableCopy;
+    for (UIView <MGLayoutBox> *view in self.subviews) {
+
+        // includes boxes waiting in the reuse pool
+        if (view.hidden) {
+            continue;
+        }
+        if ([view conformsToProtocol:@protocol(MGLayoutBox)]
+              && view.boxLayoutMode == MGBoxLayoutFixedPosition) {
+            [floating addObject:view];
+        } else {
+            [hitGrid addObject:view withFrame:view.frame];
+        }
+    }
+    floatingSubviews = floating;
 }
 
 #pragma mark - Scrolling
@@ -174,9 +361,10 @@
 }
 
 - (void)scrollViewDidScroll:(UIScrollView *)scrollView {
+    [self updateScrollVelocity];
     if (self.boxProvider) {
-        [self.boxProvider updateVisibleIndexes];
-        [MGLayoutManager layoutVisibleBoxesIn:self duration:0 completion:nil];
+        [self layoutScrolledBoxes];
+        [self.boxProvider updatePrefetchIndexes];
 
         // Apple bug workaround
         if (self.showsVerticalScrollIndicator) {
@@ -186,53 +374,177 @@
     }
 }
 
+// boxes that move tell the scroller themselves (see subviewFramesDidChange),
+// so the hit grid only needs rebuilding when boxes were recycled
+- (void)layoutScrolledBoxes {
+    NSDictionary *boxes = self.boxProvider.visibleBoxes;
+    [MGLayoutManager layoutScrolledBoxesIn:self];
+    if (![boxes isEqualToDictionary:self.boxProvider.visibleBoxes]) {
+        hitGrid = nil;
+    }
+}
+
+- (void)updateScrollVelocity {
+    CFTimeInterval now = CACurrentMediaTime();
+    CFTimeInterval elapsed = now - lastScrollTime;
+    CGPoint offset = self.contentOffset;
+
+    // a long gap means a new scroll, so start over
+    if (lastScrollTime && elapsed > 0 && elapsed < 0.1) {
+        CGPoint velocity = (CGPoint){
+            (offset.x - lastScrollOffset.x) / elapsed,
+            (offset.y - lastScrollOffset.y) / elapsed
+        };
+        _scrollVelocity = (CGPoint){
+            (_scrollVelocity.x + velocity.x) / 2,
+            (_scrollVelocity.y + velocity.y) / 2
+        };
+    } else if (elapsed > 0) {
+        _scrollVelocity = CGPointZero;
+    }
+    lastScrollTime = now;
+    lastScrollOffset = offset;
+}
+
+- (void)scrollingStopped {
+    _scrollVelocity = CGPointZero;
+    lastScrollTime = 0;
+
+    // idle, so let the adaptive buffer shrink back
+    if (self.adaptiveViewportMargin && self.boxProvider) {
+        [self layoutScrolledBoxes];
+    }
+    [self.boxProvider updatePrefetchIndexes];
+}
+
 #pragma mark - Edge snapping
 
 - (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView {
-  if (self.snapToBoxEdges) {
-    [self snapToNearestBox];
-  }
+  [self scrollingStopped];
 }
 
 - (void)scrollViewDidEndDragging:(UIScrollView *)scrollView
                   willDecelerate:(BOOL)decelerate {
-  if (self.snapToBoxEdges && !decelerate) {
-    [self snapToNearestBox];
+  if (!decelerate) {
+    [self scrollingStopped];
   }
 }
 
-- (void)snapToNearestBox {
-  if (self.contentSize.height <= self.frame.size.height) {
+- (void)scrollViewWillEndDragging:(UIScrollView *)scrollView
+      withVelocity:(CGPoint)velocity targetContentOffset:(inout CGPoint *)target {
+  if (!self.snapToBoxEdges) {
     return;
   }
-  if ([self.boxes count] < 2) {
+  target->y = [self snapOffsetFor:target->y velocity:velocity.y];
+}
+
+- (void)snapToNearestBox {
+  CGFloat y = [self snapOffsetFor:self.contentOffset.y velocity:0];
+  if (y == self.contentOffset.y) {
     return;
   }
+  [UIView animateWithDuration:0.1 animations:^{
+    self.contentOffset = CGPointMake(self.contentOffset.x, y);
+  }];
+}
 
-  CGSize size = self.frame.size;
-  CGPoint offset = self.contentOffset;
-  CGFloat fromBottom = self.contentSize.height - (offset.y + size.height);
-  CGFloat fromTop = offset.y;
-  CGFloat newY = 0;
-
-  // near the bottom? then snap to
-  UIView *last = [self.boxes lastObject];
-  if (fromBottom < last.frame.size.height / 2 && fromBottom < fromTop) {
-    newY = self.contentSize.height - size.height;
-  } else { // find nearest box
-    CGFloat oldY = offset.y;
-    CGFloat diff = self.contentSize.height;
-    for (UIView *box in self.boxes) {
-      if (ABS(box.frame.origin.y - self.bottomPadding - oldY) < diff) {
-        diff = ABS(box.frame.origin.y - oldY);
-        newY = box.frame.origin.y - self.bottomPadding;
-      }
+- (CGFloat)snapOffsetFor:(CGFloat)offset velocity:(CGFloat)velocity {
+  CGFloat minY = -self.contentInset.top;
+  CGFloat maxY = self.contentSize.height + self.contentInset.bottom - self.height;
+  if (maxY <= minY) {
+    return offset;
+  }
+
+  MGBoxFrameIndex *frames = self.snapFrames;
+  if (frames.count < 2) {
+    return offset;
+  }
+
+  CGFloat y = offset;
+  switch (self.snapMode) {
+    case MGSnapLeadingEdge:
+      y = [self nearestEdgeTo:offset + self.topPadding in:frames center:NO]
+            - self.topPadding;
+      break;
+    case MGSnapCenter:
+      y = [self nearestEdgeTo:offset + self.height / 2 in:frames center:YES]
+            - self.height / 2;
+      break;
+    case MGSnapPage:
+      y = [self pageOffsetFor:offset velocity:velocity in:frames];
+      break;
+  }
+
+  // near the bottom? then snap to it
+  if (maxY - y < self.height / 4 && maxY - offset < self.height / 4) {
+    y = maxY;
+  }
+  return MAX(minY, MIN(y, maxY));
+}
+
+- (MGBoxFrameIndex *)snapFrames {
+  if (self.boxProvider) {
+    return self.boxProvider.boxFrames;
+  }
+  MGBoxFrameIndex *frames = [MGBoxFrameIndex frameIndexWithCapacity:self.boxes.count];
+  for (UIView <MGLayoutBox> *box in self.boxes) {
+    if (box.boxLayoutMode == MGBoxLayoutAutomatic) {
+      [frames addFrame:box.frame margin:box.margin];
+    }
+  }
+  return frames;
+}
+
+// binary search to the first frame reaching below y, then check its neighbours
+- (CGFloat)nearestEdgeTo:(CGFloat)y in:(MGBoxFrameIndex *)frames center:(BOOL)center {
+  NSUInteger index = [frames firstIndexEndingBelowY:y];
+  NSUInteger from = index ? index - 1 : 0;
+  NSUInteger to = MIN(index + SNAP_SCAN_LIMIT, frames.count);
+  CGFloat best = y, bestDistance = CGFLOAT_MAX;
+  for (NSUInteger i = from; i < to; i++) {
+    CGRect frame = [frames frameAtIndex:i];
+    CGFloat edge = center ? CGRectGetMidY(frame) : CGRectGetMinY(frame);
+    CGFloat distance = fabs(edge - y);
+    if (distance < bestDistance) {
+      best = edge;
+      bestDistance = distance;
+    } else if (edge - y > bestDistance) {
+      break; // everything further on is further away
     }
   }
+  return best;
+}
 
-  [UIView animateWithDuration:0.1 animations:^{
-    self.contentOffset = CGPointMake(0, newY);
-  }];
+- (CGFloat)pageOffsetFor:(CGFloat)offset velocity:(CGFloat)velocity
+      in:(MGBoxFrameIndex *)frames {
+
+  // boxes per row, from those sharing the first box's top edge
+  CGFloat firstTop = CGRectGetMinY([frames frameAtIndex:0]);
+  NSUInteger columns = 1;
+  while (columns < frames.count && columns < SNAP_SCAN_LIMIT
+        && CGRectGetMinY([frames frameAtIndex:columns]) == firstTop) {
+    columns++;
+  }
+  NSUInteger perPage = MAX(self.snapPageSize, 1) * columns;
+  NSUInteger pages = (frames.count + perPage - 1) / perPage;
+
+  // the page the current offset is in, from where the drag ended
+  CGFloat current = self.contentOffset.y + self.topPadding;
+  NSUInteger page = MIN([frames firstIndexEndingBelowY:current], frames.count - 1) / perPage;
+  CGFloat pageTop = CGRectGetMinY([frames frameAtIndex:page * perPage]);
+  CGFloat nextTop = page + 1 < pages
+        ? CGRectGetMinY([frames frameAtIndex:(page + 1) * perPage]) : pageTop;
+
+  CGFloat top;
+  if (velocity > 0) {
+    top = nextTop;
+  } else if (velocity < 0) {
+    top = current > pageTop || !page
+          ? pageTop : CGRectGetMinY([frames frameAtIndex:(page - 1) * perPage]);
+  } else {
+    top = current - pageTop < nextTop - current ? pageTop : nextTop;
+  }
+  return top - self.topPadding;
 }
 
 #pragma mark - Dealing with the keyboard
@@ -302,14 +614,44 @@
 #pragma mark - Scroll Offset Handling
 
 - (void)restoreScrollOffset {
-    
-    [self.boxProvider resetBoxCache];
-    [self.boxProvider updateDataKeys];
-    [self.boxProvider updateBoxFrames];
-    self.boxProvider.lockVisibleIndexes = YES;
+    MGBoxProvider *provider = self.boxProvider;
+    NSUInteger anchorIndex = NSNotFound;
+
+    // only restack as far as the anchor and a screenful past it
+    if (provider) {
+        [provider updateDataKeys];
+        anchorIndex = [provider indexOfDataKey:_anchorKey];
+        [provider updateBoxFramesThroughIndex:anchorIndex height:self.height];
+    }
+    provider.lockVisibleIndexes = YES;
     [MGLayoutManager updateContentSizeFor:self];
-    self.boxProvider.lockVisibleIndexes = NO;
+    provider.lockVisibleIndexes = NO;
+
+    // keep the anchor box at the same distance from the top of the viewport
+    CGPoint newOffset = self.offsetForPreviousScrollRatio;
+    CGFloat anchorY = NAN;
+    if (anchorIndex != NSNotFound) {
+        anchorY = CGRectGetMinY([provider frameForBoxAtIndex:anchorIndex]);
+    } else if (!provider && _anchorBox.superview == self) {
+        anchorY = _anchorBox.frame.origin.y;
+    }
+    if (!isnan(anchorY)) {
+        CGFloat minY = -self.contentInset.top;
+        CGFloat maxY = self.contentSize.height + self.contentInset.bottom - self.height;
+        newOffset.y = MAX(minY, MIN(anchorY - _anchorTop - self.contentInset.top, maxY));
+    }
+
+    if (CGPointEqualToPoint(newOffset, self.contentOffset)) {
+        [self scrollViewDidScroll:self];
+    } else {
+        self.contentOffset = newOffset;
+    }
 
+    [provider updateOldBoxFrames];
+    [provider updateOldDataKeys];
+}
+
+- (CGPoint)offsetForPreviousScrollRatio {
     CGSize sizeMinusInsets = CGSizeMake(_previousFrame.size.width -
                                         _previousContentInset.right -
                                         _previousContentInset.left,
@@ -334,20 +676,10 @@
     maxOffset = CGPointMake(MAX(sizeMinusInsets.width, self.contentSize.width) - sizeMinusInsets.width,
                             MAX(sizeMinusInsets.height, self.contentSize.height) - sizeMinusInsets.height);
 
-    CGPoint newOffset = (CGPoint){
+    return (CGPoint){
         -self.contentInset.left + scrollRatio.x * maxOffset.x,
         -self.contentInset.top + scrollRatio.y * maxOffset.y
     };
-
-
-    if (CGPointEqualToPoint(newOffset, self.contentOffset)) {
-        [self scrollViewDidScroll:self];
-    } else {
-        self.contentOffset = newOffset;
-    }
-
-    [self.boxProvider updateOldBoxFrames];
-    [self.boxProvider updateOldDataKeys];
 }
 
 - (void)saveScrollOffset {
@@ -355,6 +687,26 @@
     _previousContentOffset = self.contentOffset;
     _previousContentSize = self.contentSize;
     _previousContentInset = self.contentInset;
+
+    // the first box reaching into the viewport is the anchor
+    CGFloat top = self.contentOffset.y + self.contentInset.top;
+    _anchorKey = nil;
+    _anchorBox = nil;
+    if (self.boxProvider) {
+        MGBoxFrameIndex *frames = self.boxProvider.boxFrames;
+        NSUInteger index = [frames firstIndexEndingBelowY:top];
+        if (index < frames.count) {
+            _anchorKey = [self.boxProvider keyForBoxAtIndex:index];
+            _anchorTop = CGRectGetMinY([frames frameAtIndex:index]) - top;
+        }
+    } else {
+        for (UIView <MGLayoutBox> *box in self.boxes) {
+            if (box.bottom > top && (!_anchorBox || box.top < _anchorBox.top)) {
+                _anchorBox = box;
+            }
+        }
+        _anchorTop = _anchorBox.top - top;
+    }
 }
 
 #pragma mark - Setters
@@ -397,8 +749,38 @@
   provider.container = self;
 }
 
+- (void)setShowsPerformanceHUD:(BOOL)shows {
+  if (shows == self.showsPerformanceHUD) {
+    return;
+  }
+  if (shows) {
+    performanceHUD = [MGPerformanceHUD hudForScroller:self];
+    [self.superview addSubview:performanceHUD];
+  } else {
+    [performanceHUD removeFromSuperview];
+    performanceHUD = nil;
+  }
+}
+
+// the HUD sits beside the scroller, so it doesn't scroll or get laid out
+- (void)didMoveToSuperview {
+  [super didMoveToSuperview];
+  if (!performanceHUD) {
+    return;
+  }
+  if (self.superview) {
+    [self.superview addSubview:performanceHUD];
+  } else {
+    [performanceHUD removeFromSuperview];
+  }
+}
+
 #pragma mark - Getters
 
+- (BOOL)showsPerformanceHUD {
+  return performanceHUD != nil;
+}
+
 - (NSMutableArray *)boxes {
   if (!boxes) {
     boxes = @[].mutableCopy;
@@ -407,13 +789,34 @@
 }
 
 - (CGRect)bufferedViewport {
-    UIEdgeInsets buffer = UIEdgeInsetsMake(-self.viewportMargin.height,
-          -self.viewportMargin.width, -self.viewportMargin.height, -self.viewportMargin.width);
+    UIEdgeInsets buffer = self.adaptiveViewportMargin
+          ? self.adaptiveViewportInsets
+          : UIEdgeInsetsMake(self.viewportMargin.height, self.viewportMargin.width,
+                self.viewportMargin.height, self.viewportMargin.width);
+    buffer = UIEdgeInsetsMake(-buffer.top, -buffer.left, -buffer.bottom, -buffer.right);
     CGRect frame = (CGRect){CGPointZero, self.size};
     return CGRectOffset(UIEdgeInsetsInsetRect(frame, buffer), self.contentOffset.x,
           self.contentOffset.y);
 }
 
+- (UIEdgeInsets)adaptiveViewportInsets {
+    CGSize base = self.viewportMargin;
+    CGSize cap = CGSizeEqualToSize(self.maxViewportMargin, CGSizeZero)
+          ? self.size : self.maxViewportMargin;
+    CGPoint velocity = self.scrollVelocity;
+
+    CGFloat aheadY = MIN(MAX(base.height, fabs(velocity.y) * ADAPTIVE_LEAD_TIME), cap.height);
+    CGFloat aheadX = MIN(MAX(base.width, fabs(velocity.x) * ADAPTIVE_LEAD_TIME), cap.width);
+    CGFloat behindY = base.height / (1 + fabs(velocity.y) / ADAPTIVE_TRAIL_SPEED);
+    CGFloat behindX = base.width / (1 + fabs(velocity.x) / ADAPTIVE_TRAIL_SPEED);
+
+    return UIEdgeInsetsMake(
+          velocity.y < 0 ? aheadY : behindY,
+          velocity.x < 0 ? aheadX : behindX,
+          velocity.y > 0 ? aheadY : behindY,
+          velocity.x > 0 ? aheadX : behindX);
+}
+
 - (UIEdgeInsets)margin {
   return UIEdgeInsetsMake(self.topMargin, self.leftMargin, self.bottomMargin,
       self.rightMargin);
@@ -448,6 +851,42 @@
   return tapper;
 }
 
+- (UITapGestureRecognizer *)boxTapper {
+  if (!boxTapper) {
+    boxTapper = [[UITapGestureRecognizer alloc]
+        initWithTarget:self action:@selector(boxTapped:)];
+    boxTapper.delegate = self;
+  }
+  return boxTapper;
+}
+
+- (UILongPressGestureRecognizer *)boxLongPresser {
+  if (!boxLongPresser) {
+    boxLongPresser = [[UILongPressGestureRecognizer alloc]
+        initWithTarget:self action:@selector(boxLongPressed:)];
+    boxLongPresser.delegate = self;
+  }
+  return boxLongPresser;
+}
+
+- (NSArray *)boxSwipers {
+  if (!boxSwipers) {
+    NSMutableArray *swipers = @[].mutableCopy;
+    for (NSNumber *direction in @[
+        @(UISwipeGestureRecognizerDirectionRight), @(UISwipeGestureRecognizerDirectionLeft),
+        @(UISwipeGestureRecognizerDirectionUp), @(UISwipeGestureRecognizerDirectionDown)
+    ]) {
+      UISwipeGestureRecognizer *swiper = [[UISwipeGestureRecognizer alloc]
+          initWithTarget:self action:@selector(boxSwiped:)];
+      swiper.direction = direction.unsignedIntegerValue;
+      swiper.delegate = self;
+      [swipers addObject:swiper];
+    }
+    boxSwipers = swipers;
+  }
+  return boxSwipers;
+}
+
 #pragma mark - Fini
 
 - (void)dealloc {
@@ -0,0 +1,167 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+@class MGBoxProvider;
+
+#pragma mark - Trace format
+
+#define MG_TRACE_MAGIC 0x5453474d // "MGST"
+#define MG_TRACE_VERSION 2
+
+typedef enum {
+    MGTraceConfigEvent = 1,
+    MGTraceCountEvent,
+    MGTraceKeyEvent,
+    MGTraceSizeEvent,
+    MGTraceMarginEvent,
+    MGTraceLayoutEvent,
+    MGTraceRowHeightEvent,
+    MGTraceColumnWidthEvent
+} MGTraceEventType;
+
+typedef enum {
+    MGTraceFullLayout,
+    MGTraceAnimatedLayout,
+    MGTraceAppendedLayout,
+    MGTraceScrolledLayout
+} MGTraceLayoutKind;
+
+typedef enum {
+    MGTraceNoKeys, MGTraceObjectKeys, MGTraceIntegerKeys
+} MGTraceKeyMode;
+
+// every event starts with its MGTraceEventType byte. sizes are stored as
+// floats, and indexes and counts as 32 bit
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t version;
+} MGTraceHeader;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t layoutMode;
+    uint8_t keyMode;
+    uint8_t hasSizeMaker;
+    uint8_t hasMarginMaker;
+    uint8_t hasRowHeightMaker;
+    uint8_t hasColumnWidthMaker;
+    uint32_t columnCount;
+    float padding[4];
+    float viewportMargin[2];
+    float uniformBoxSize[2];
+    float uniformBoxMargin[4];
+} MGTraceConfig;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint32_t count;
+} MGTraceCount;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint32_t index;
+    uint64_t key;
+} MGTraceKey;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint32_t index;
+    float size[2];
+} MGTraceSize;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint32_t index;
+    float margin[4];
+} MGTraceMargin;
+
+// a two dimensional grid's row height or column width
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint32_t index;
+    float length;
+} MGTraceDimension;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t kind;
+    float duration;
+    float containerSize[2];
+    float contentOffset[2];
+    uint64_t frameChecksum;
+    uint64_t visibilityChecksum;
+} MGTraceLayout;
+
+#pragma mark - Recorder
+
+/**
+Records a box provider's session to a compact trace file, for reproducing and
+benchmarking it later with <MGSessionReplayer>: the results of its `counter`,
+key, size, margin, row height, and column width blocks, and each layout pass of
+its container, with the container size, scroll offset, time taken, and
+checksums of the visible indexes and their frames.
+
+    self.scroller.boxProvider.sessionRecorder = [MGSessionRecorder
+          recorderWithPath:[NSTemporaryDirectory()
+          stringByAppendingPathComponent:@"feed.trace"]];
+
+    // ... later, to finish the trace
+    self.scroller.boxProvider.sessionRecorder = nil;
+
+Block results are only written when they differ from the last result recorded
+for the same index, so a session of many layout passes over the same data
+stays small. Data keys are kept as 64 bit values, which is all replaying needs
+to match boxes up between passes: integer keys as they are, `NSNumber` and
+`NSString` keys as hashes of their values, and other keys numbered in the order
+they were first seen.
+
+The recorder wraps the provider's blocks while recording, so it should be set
+after they are. Nothing is recorded, and the provider pays nothing beyond a
+`nil` check per layout pass, while no recorder is set.
+*/
+
+@interface MGSessionRecorder : NSObject
+
++ (instancetype)recorderWithPath:(NSString *)path;
+
+@property (nonatomic, readonly) NSString *path;
+
+@property (nonatomic, readonly) BOOL recording;
+
+/** The number of events written so far. */
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/**
+* Writes the trace header and starts recording the given provider. Usually
+* called by setting the provider's
+* [sessionRecorder](-[MGBoxProvider sessionRecorder]).
+*/
+- (void)startRecordingProvider:(MGBoxProvider *)provider;
+
+/**
+* Puts the provider's blocks back and finishes the trace file.
+*/
+- (void)stopRecording;
+
+/** @name Checksums */
+
+/**
+* A hash of the provider's visible indexes.
+*/
++ (uint64_t)visibilityChecksumFor:(MGBoxProvider *)provider;
+
+/**
+* A hash of the provider's visible indexes and their frames, rounded to 1/64 pt.
+*/
++ (uint64_t)frameChecksumFor:(MGBoxProvider *)provider;
+
+#pragma mark - Ignore below here plz
+
+/** @name Internal */
+
+- (void)recordLayout:(MGTraceLayoutKind)kind duration:(NSTimeInterval)duration;
+
+@end
@@ -0,0 +1,418 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGSessionRecorder.h"
+#import "MGBoxProvider.h"
+#import "MGScrollView.h"
+
+// buffered trace bytes written out at a time
+#define TRACE_FLUSH_SIZE 65536
+
+#define FNV_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// which results have been recorded for an index, and what they were
+typedef struct {
+    uint8_t recorded;
+    uint64_t key;
+    float size[2];
+    float margin[4];
+} MGTraceSlot;
+
+enum { MGSlotKey = 1, MGSlotSize = 2, MGSlotMargin = 4 };
+
+// the last row height or column width recorded for an index
+typedef struct {
+    uint8_t recorded;
+    float length;
+} MGTraceDimensionSlot;
+
+static inline uint64_t MGTraceHash(uint64_t hash, const void *bytes, size_t length) {
+    const uint8_t *byte = bytes;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ byte[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// frames are compared in steps of 1/64 pt
+#define FRAME_STEPS 64
+
+@implementation MGSessionRecorder {
+    __weak MGBoxProvider *_provider;
+    NSFileHandle *_file;
+    NSMutableData *_buffer;
+    NSMutableData *_slots, *_rowSlots, *_columnSlots;
+    NSUInteger _lastCount;
+    BOOL _wroteConfig;
+    NSMutableDictionary *_originalBlocks, *_wrappedBlocks;
+    NSMutableDictionary *_keyOrdinals;
+}
+
++ (instancetype)recorderWithPath:(NSString *)path {
+    MGSessionRecorder *recorder = [[self alloc] init];
+    recorder->_path = path.copy;
+    return recorder;
+}
+
+- (void)dealloc {
+    [self stopRecording];
+}
+
+#pragma mark - Starting and stopping
+
+- (void)startRecordingProvider:(MGBoxProvider *)provider {
+    NSAssert(!_recording, @"A session recorder can only record one provider at a time");
+    [NSFileManager.defaultManager createFileAtPath:self.path contents:nil attributes:nil];
+    _file = [NSFileHandle fileHandleForWritingAtPath:self.path];
+    if (!_file) {
+        return;
+    }
+
+    _provider = provider;
+    _recording = YES;
+    _eventCount = 0;
+    _lastCount = NSNotFound;
+    _wroteConfig = NO;
+    _buffer = [NSMutableData dataWithCapacity:TRACE_FLUSH_SIZE];
+    _slots = NSMutableData.new;
+    _rowSlots = NSMutableData.new;
+    _columnSlots = NSMutableData.new;
+    _keyOrdinals = NSMutableDictionary.new;
+
+    MGTraceHeader header = {MG_TRACE_MAGIC, MG_TRACE_VERSION};
+    [_buffer appendBytes:&header length:sizeof(header)];
+
+    [self wrapBlocksOf:provider];
+}
+
+- (void)stopRecording {
+    if (!_recording) {
+        return;
+    }
+    _recording = NO;
+
+    // only put back blocks that haven't been replaced since
+    MGBoxProvider *provider = _provider;
+    for (NSString *name in _wrappedBlocks) {
+        if ([provider valueForKey:name] == _wrappedBlocks[name]) {
+            [provider setValue:_originalBlocks[name] forKey:name];
+        }
+    }
+    _originalBlocks = _wrappedBlocks = nil;
+
+    [self flush];
+    [_file closeFile];
+    _file = nil;
+    _buffer = nil;
+    _slots = _rowSlots = _columnSlots = nil;
+    _keyOrdinals = nil;
+}
+
+#pragma mark - Wrapping the provider's blocks
+
+- (void)wrapBlocksOf:(MGBoxProvider *)provider {
+    __weak MGSessionRecorder *me = self;
+    _originalBlocks = NSMutableDictionary.new;
+    _wrappedBlocks = NSMutableDictionary.new;
+
+    MGCounter counter = provider.counter;
+    if (counter) {
+        [self wrap:@"counter" of:provider original:counter with:^NSUInteger {
+            NSUInteger count = counter();
+            [me recordCount:count];
+            return count;
+        }];
+    }
+
+    MGBoxKeyMaker keyMaker = provider.boxKeyMaker;
+    if (keyMaker) {
+        [self wrap:@"boxKeyMaker" of:provider original:keyMaker with:^id(NSUInteger index) {
+            id key = keyMaker(index);
+            [me recordKey:[me hashOfKey:key] at:index];
+            return key;
+        }];
+    }
+
+    MGBoxIntegerKeyMaker integerKeyMaker = provider.boxIntegerKeyMaker;
+    if (integerKeyMaker) {
+        [self wrap:@"boxIntegerKeyMaker" of:provider original:integerKeyMaker
+              with:^uint64_t(NSUInteger index) {
+                  uint64_t key = integerKeyMaker(index);
+                  [me recordKey:key at:index];
+                  return key;
+              }];
+    }
+
+    MGBoxSizeMaker sizeMaker = provider.boxSizeMaker;
+    if (sizeMaker) {
+        [self wrap:@"boxSizeMaker" of:provider original:sizeMaker with:^CGSize(NSUInteger index) {
+            CGSize size = sizeMaker(index);
+            [me recordSize:size at:index];
+            return size;
+        }];
+    }
+
+    MGBoxMarginMaker marginMaker = provider.boxMarginMaker;
+    if (marginMaker) {
+        [self wrap:@"boxMarginMaker" of:provider original:marginMaker
+              with:^UIEdgeInsets(NSUInteger index) {
+                  UIEdgeInsets margin = marginMaker(index);
+                  [me recordMargin:margin at:index];
+                  return margin;
+              }];
+    }
+
+    MGBoxDimensionMaker rowHeightMaker = provider.rowHeightMaker;
+    if (rowHeightMaker) {
+        [self wrap:@"rowHeightMaker" of:provider original:rowHeightMaker
+              with:^CGFloat(NSUInteger row) {
+                  CGFloat height = rowHeightMaker(row);
+                  [me recordRowHeight:height at:row];
+                  return height;
+              }];
+    }
+
+    MGBoxDimensionMaker columnWidthMaker = provider.columnWidthMaker;
+    if (columnWidthMaker) {
+        [self wrap:@"columnWidthMaker" of:provider original:columnWidthMaker
+              with:^CGFloat(NSUInteger column) {
+                  CGFloat width = columnWidthMaker(column);
+                  [me recordColumnWidth:width at:column];
+                  return width;
+              }];
+    }
+}
+
+- (void)wrap:(NSString *)name of:(MGBoxProvider *)provider original:(id)original
+      with:(id)wrapper {
+    wrapper = [wrapper copy];
+    _originalBlocks[name] = original;
+    _wrappedBlocks[name] = wrapper;
+    [provider setValue:wrapper forKey:name];
+}
+
+#pragma mark - Recording block results
+
+- (void)recordCount:(NSUInteger)count {
+    if (!_recording || count == _lastCount) {
+        return;
+    }
+    _lastCount = count;
+    MGTraceCount event = {MGTraceCountEvent, (uint32_t)count};
+    [self append:&event length:sizeof(event)];
+}
+
+- (void)recordKey:(uint64_t)key at:(NSUInteger)index {
+    MGTraceSlot *slot = [self slotAt:index];
+    if (!slot || (slot->recorded & MGSlotKey && slot->key == key)) {
+        return;
+    }
+    slot->recorded |= MGSlotKey;
+    slot->key = key;
+    MGTraceKey event = {MGTraceKeyEvent, (uint32_t)index, key};
+    [self append:&event length:sizeof(event)];
+}
+
+- (void)recordSize:(CGSize)size at:(NSUInteger)index {
+    MGTraceSlot *slot = [self slotAt:index];
+    float w = size.width, h = size.height;
+    if (!slot || (slot->recorded & MGSlotSize && slot->size[0] == w && slot->size[1] == h)) {
+        return;
+    }
+    slot->recorded |= MGSlotSize;
+    slot->size[0] = w;
+    slot->size[1] = h;
+    MGTraceSize event = {MGTraceSizeEvent, (uint32_t)index, {w, h}};
+    [self append:&event length:sizeof(event)];
+}
+
+- (void)recordMargin:(UIEdgeInsets)margin at:(NSUInteger)index {
+    MGTraceSlot *slot = [self slotAt:index];
+    float m[4] = {margin.top, margin.left, margin.bottom, margin.right};
+    if (!slot || (slot->recorded & MGSlotMargin && !memcmp(slot->margin, m, sizeof(m)))) {
+        return;
+    }
+    slot->recorded |= MGSlotMargin;
+    memcpy(slot->margin, m, sizeof(m));
+    MGTraceMargin event = {MGTraceMarginEvent, (uint32_t)index};
+    memcpy(event.margin, m, sizeof(m));
+    [self append:&event length:sizeof(event)];
+}
+
+- (void)recordRowHeight:(CGFloat)height at:(NSUInteger)row {
+    [self recordDimension:height at:row type:MGTraceRowHeightEvent in:_rowSlots];
+}
+
+- (void)recordColumnWidth:(CGFloat)width at:(NSUInteger)column {
+    [self recordDimension:width at:column type:MGTraceColumnWidthEvent in:_columnSlots];
+}
+
+- (void)recordDimension:(CGFloat)length at:(NSUInteger)index type:(uint8_t)type
+      in:(NSMutableData *)slots {
+    if (!_recording) {
+        return;
+    }
+    NSUInteger needed = (index + 1) * sizeof(MGTraceDimensionSlot);
+    if (slots.length < needed) {
+        slots.length = MAX(needed, slots.length * 2); // zero filled
+    }
+    MGTraceDimensionSlot *slot = (MGTraceDimensionSlot *)slots.mutableBytes + index;
+    float value = length;
+    if (slot->recorded && slot->length == value) {
+        return;
+    }
+    slot->recorded = YES;
+    slot->length = value;
+    MGTraceDimension event = {type, (uint32_t)index, value};
+    [self append:&event length:sizeof(event)];
+}
+
+// numbers and strings are hashed by value, each with its own tag, so eg @1,
+// @1.5, and @"1" all differ. other keys can't be hashed safely, so are
+// numbered in the order they're first seen, which is all replaying needs
+- (uint64_t)hashOfKey:(id)key {
+    if (!key) {
+        return 0;
+    }
+    uint8_t tag;
+    uint64_t hash = FNV_BASIS;
+    if ([key isKindOfClass:NSNumber.class]) {
+        tag = 'n';
+        hash = MGTraceHash(hash, &tag, 1);
+        const char *type = [key objCType];
+        NSUInteger size;
+        NSGetSizeAndAlignment(type, &size, NULL);
+        uint8_t value[size];
+        memset(value, 0, size);
+        [key getValue:value];
+        hash = MGTraceHash(hash, type, strlen(type));
+        return MGTraceHash(hash, value, size);
+    }
+    if ([key isKindOfClass:NSString.class]) {
+        tag = 's';
+        hash = MGTraceHash(hash, &tag, 1);
+        const char *utf8 = [key UTF8String];
+        return MGTraceHash(hash, utf8, strlen(utf8));
+    }
+    NSNumber *ordinal = _keyOrdinals[key];
+    if (!ordinal) {
+        ordinal = @(_keyOrdinals.count);
+        _keyOrdinals[key] = ordinal;
+    }
+    tag = 'o';
+    uint64_t value = ordinal.unsignedLongLongValue;
+    hash = MGTraceHash(hash, &tag, 1);
+    return MGTraceHash(hash, &value, sizeof(value));
+}
+
+// the last results recorded for the index, or nil if not recording
+- (MGTraceSlot *)slotAt:(NSUInteger)index {
+    if (!_recording) {
+        return NULL;
+    }
+    NSUInteger needed = (index + 1) * sizeof(MGTraceSlot);
+    if (_slots.length < needed) {
+        _slots.length = MAX(needed, _slots.length * 2); // zero filled
+    }
+    return (MGTraceSlot *)_slots.mutableBytes + index;
+}
+
+#pragma mark - Recording layout passes
+
+- (void)recordLayout:(MGTraceLayoutKind)kind duration:(NSTimeInterval)duration {
+    MGBoxProvider *provider = _provider;
+    UIView <MGLayoutBox> *container = provider.container;
+    if (!_recording || !container) {
+        return;
+    }
+    if (!_wroteConfig) {
+        [self recordConfigOf:provider];
+    }
+
+    CGSize size = container.bounds.size;
+    CGPoint offset = [container isKindOfClass:UIScrollView.class]
+          ? [(UIScrollView *)container contentOffset]
+          : CGPointZero;
+    MGTraceLayout event = {
+        MGTraceLayoutEvent, kind, duration, {size.width, size.height},
+        {offset.x, offset.y}, [MGSessionRecorder frameChecksumFor:provider],
+        [MGSessionRecorder visibilityChecksumFor:provider]
+    };
+    [self append:&event length:sizeof(event)];
+}
+
+- (void)recordConfigOf:(MGBoxProvider *)provider {
+    UIView <MGLayoutBox> *container = provider.container;
+    UIEdgeInsets padding = container.padding;
+    CGSize viewportMargin = [container isKindOfClass:MGScrollView.class]
+          ? [(MGScrollView *)container viewportMargin]
+          : CGSizeZero;
+    UIEdgeInsets uniformMargin = provider.uniformBoxMargin;
+
+    MGTraceConfig event = {
+        MGTraceConfigEvent, container.contentLayoutMode,
+        provider.boxIntegerKeyMaker ? MGTraceIntegerKeys
+              : provider.boxKeyMaker ? MGTraceObjectKeys : MGTraceNoKeys,
+        provider.boxSizeMaker != nil, provider.boxMarginMaker != nil,
+        provider.rowHeightMaker != nil, provider.columnWidthMaker != nil,
+        (uint32_t)provider.columnCount,
+        {padding.top, padding.left, padding.bottom, padding.right},
+        {viewportMargin.width, viewportMargin.height},
+        {provider.uniformBoxSize.width, provider.uniformBoxSize.height},
+        {uniformMargin.top, uniformMargin.left, uniformMargin.bottom, uniformMargin.right}
+    };
+    [self append:&event length:sizeof(event)];
+    _wroteConfig = YES;
+}
+
+#pragma mark - Writing
+
+- (void)append:(const void *)event length:(NSUInteger)length {
+    [_buffer appendBytes:event length:length];
+    _eventCount++;
+    if (_buffer.length >= TRACE_FLUSH_SIZE) {
+        [self flush];
+    }
+}
+
+- (void)flush {
+    if (_buffer.length) {
+        [_file writeData:_buffer];
+        _buffer.length = 0;
+    }
+}
+
+#pragma mark - Checksums
+
++ (uint64_t)visibilityChecksumFor:(MGBoxProvider *)provider {
+    __block uint64_t hash = FNV_BASIS;
+    [provider.visibleIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        uint32_t value = (uint32_t)index;
+        hash = MGTraceHash(hash, &value, sizeof(value));
+    }];
+    return hash;
+}
+
+// frames are rounded to 1/64 pt before hashing, so that rounding noise in
+// CGFloat arithmetic (eg 32 vs 64 bit) mostly doesn't count as a mismatch. a
+// value that lands either side of a step can still differ
++ (uint64_t)frameChecksumFor:(MGBoxProvider *)provider {
+    __block uint64_t hash = FNV_BASIS;
+    [provider.visibleIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        CGRect frame = [provider frameForBoxAtIndex:index];
+        struct { uint32_t index; int32_t frame[4]; } value = {
+            (uint32_t)index, {
+                (int32_t)round(frame.origin.x * FRAME_STEPS),
+                (int32_t)round(frame.origin.y * FRAME_STEPS),
+                (int32_t)round(frame.size.width * FRAME_STEPS),
+                (int32_t)round(frame.size.height * FRAME_STEPS)
+            }
+        };
+        hash = MGTraceHash(hash, &value, sizeof(value));
+    }];
+    return hash;
+}
+
+@end
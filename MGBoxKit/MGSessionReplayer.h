@@ -0,0 +1,71 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+/**
+The results of replaying a trace with <MGSessionReplayer>.
+*/
+@interface MGSessionReplayReport : NSObject
+
+/** The number of layout passes replayed, including scroll driven passes. */
+@property (nonatomic, readonly) NSUInteger layoutCount;
+@property (nonatomic, readonly) NSUInteger scrollCount;
+
+/** The time the replayed layout passes took, in seconds. */
+@property (nonatomic, readonly) NSTimeInterval totalTime;
+@property (nonatomic, readonly) NSTimeInterval longestTime;
+
+/** The time the same passes took when the trace was recorded. */
+@property (nonatomic, readonly) NSTimeInterval recordedTotalTime;
+@property (nonatomic, readonly) NSTimeInterval recordedLongestTime;
+
+/**
+* Every pass's visibility and frame checksums (see <MGSessionRecorder>) rolled
+* into one, for comparing replays against each other.
+*/
+@property (nonatomic, readonly) uint64_t visibilityChecksum;
+@property (nonatomic, readonly) uint64_t frameChecksum;
+
+/**
+* The number of passes whose checksums differ from the recorded ones, and the
+* first of them, or `NSNotFound` if they all match.
+*/
+@property (nonatomic, readonly) NSUInteger mismatchCount;
+@property (nonatomic, readonly) NSUInteger firstMismatch;
+
+@end
+
+/**
+Replays a trace written by <MGSessionRecorder> through the layout pipeline,
+without the app or its data, for reproducing and benchmarking a recorded
+session deterministically, eg in a unit test or on a CI build machine.
+
+    MGSessionReplayReport *report = [MGSessionReplayer replayTraceAtPath:path];
+    XCTAssertEqual(report.mismatchCount, 0);
+    NSLog(@"%@", report);
+
+An offscreen `MGScrollView` is given the recorded container size, layout mode,
+padding, and viewport margin, and a provider whose `counter`, key, size,
+margin, row height, and column width blocks answer from the trace, with a plain
+`MGBox` for every box. Each
+recorded layout pass is then replayed in order, with scroll passes replayed by
+setting the recorded content offset. Animated layouts are replayed without
+animation.
+
+Replaying needs UIKit, so runs in the simulator or on a device, but needs
+nothing else from the recording app.
+*/
+
+@interface MGSessionReplayer : NSObject
+
+/**
+* Replays the trace and returns what happened, or `nil` if the file isn't a
+* readable trace. Must be called on the main thread.
+*/
++ (MGSessionReplayReport *)replayTraceAtPath:(NSString *)path;
+
++ (MGSessionReplayReport *)replayTrace:(NSData *)trace;
+
+@end
@@ -0,0 +1,383 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGSessionReplayer.h"
+#import "MGSessionRecorder.h"
+#import "MGScrollView.h"
+#import "MGBoxProvider.h"
+#import "MGBox.h"
+
+#define FNV_PRIME 0x100000001b3ULL
+
+// the results the provider's blocks give for an index
+typedef struct {
+    uint8_t seen;
+    uint64_t key;
+    CGSize size;
+    UIEdgeInsets margin;
+} MGReplaySlot;
+
+enum { MGSeenKey = 1, MGSeenSize = 2, MGSeenMargin = 4 };
+
+// a two dimensional grid's row height or column width
+typedef struct {
+    uint8_t seen;
+    CGFloat length;
+} MGReplayDimension;
+
+static size_t MGTraceEventLength(uint8_t type) {
+    switch (type) {
+        case MGTraceConfigEvent:
+            return sizeof(MGTraceConfig);
+        case MGTraceCountEvent:
+            return sizeof(MGTraceCount);
+        case MGTraceKeyEvent:
+            return sizeof(MGTraceKey);
+        case MGTraceSizeEvent:
+            return sizeof(MGTraceSize);
+        case MGTraceMarginEvent:
+            return sizeof(MGTraceMargin);
+        case MGTraceLayoutEvent:
+            return sizeof(MGTraceLayout);
+        case MGTraceRowHeightEvent:
+        case MGTraceColumnWidthEvent:
+            return sizeof(MGTraceDimension);
+        default:
+            return 0;
+    }
+}
+
+@interface MGSessionReplayReport ()
+@property (nonatomic, assign) NSUInteger layoutCount;
+@property (nonatomic, assign) NSUInteger scrollCount;
+@property (nonatomic, assign) NSTimeInterval totalTime;
+@property (nonatomic, assign) NSTimeInterval longestTime;
+@property (nonatomic, assign) NSTimeInterval recordedTotalTime;
+@property (nonatomic, assign) NSTimeInterval recordedLongestTime;
+@property (nonatomic, assign) uint64_t visibilityChecksum;
+@property (nonatomic, assign) uint64_t frameChecksum;
+@property (nonatomic, assign) NSUInteger mismatchCount;
+@property (nonatomic, assign) NSUInteger firstMismatch;
+@end
+
+@implementation MGSessionReplayReport
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"%lu layout passes (%lu scrolls) in %.2f ms, "
+          "longest %.2f ms (recorded %.2f ms, longest %.2f ms), "
+          "checksums %016llx %016llx, %lu mismatched",
+          (unsigned long)self.layoutCount, (unsigned long)self.scrollCount,
+          self.totalTime * 1000, self.longestTime * 1000,
+          self.recordedTotalTime * 1000, self.recordedLongestTime * 1000,
+          self.visibilityChecksum, self.frameChecksum,
+          (unsigned long)self.mismatchCount];
+}
+
+@end
+
+@implementation MGSessionReplayer {
+    NSData *_trace;
+    NSUInteger _count;
+    NSMutableData *_slots, *_rowHeights, *_columnWidths;
+    MGScrollView *_scroller;
+    MGSessionReplayReport *_report;
+}
+
++ (MGSessionReplayReport *)replayTraceAtPath:(NSString *)path {
+    NSData *trace = [NSData dataWithContentsOfFile:path
+          options:NSDataReadingMappedIfSafe error:nil];
+    return trace ? [self replayTrace:trace] : nil;
+}
+
++ (MGSessionReplayReport *)replayTrace:(NSData *)trace {
+    NSAssert(NSThread.isMainThread, @"Traces must be replayed on the main thread");
+    if (trace.length < sizeof(MGTraceHeader)) {
+        return nil;
+    }
+    MGTraceHeader header;
+    memcpy(&header, trace.bytes, sizeof(header));
+    if (header.magic != MG_TRACE_MAGIC || header.version != MG_TRACE_VERSION) {
+        return nil;
+    }
+
+    MGSessionReplayer *replayer = [[self alloc] init];
+    replayer->_trace = trace;
+    return [replayer replay];
+}
+
+#pragma mark - Replaying
+
+- (MGSessionReplayReport *)replay {
+    _slots = NSMutableData.new;
+    _rowHeights = NSMutableData.new;
+    _columnWidths = NSMutableData.new;
+    _count = NSNotFound;
+
+    // blocks can be asked about an index before its results were recorded
+    // (eg frames stacked later on), so start with each index's first results
+    BOOL readable = [self eachEvent:^(const uint8_t *event) {
+        [self applyResult:event firstOnly:YES];
+    }];
+    if (!readable) {
+        return nil;
+    }
+    if (_count == NSNotFound) {
+        _count = 0;
+    }
+
+    _report = MGSessionReplayReport.new;
+    _report.firstMismatch = NSNotFound;
+    [self eachEvent:^(const uint8_t *event) {
+        if (event[0] == MGTraceConfigEvent) {
+            MGTraceConfig config;
+            memcpy(&config, event, sizeof(config));
+            [self applyConfig:config];
+        } else if (event[0] == MGTraceLayoutEvent) {
+            MGTraceLayout layout;
+            memcpy(&layout, event, sizeof(layout));
+            [self replayLayout:layout];
+        } else {
+            [self applyResult:event firstOnly:NO];
+        }
+    }];
+
+    return _report;
+}
+
+// NO if the trace is truncated or has an unknown event
+- (BOOL)eachEvent:(void (^)(const uint8_t *event))block {
+    const uint8_t *bytes = _trace.bytes;
+    NSUInteger offset = sizeof(MGTraceHeader);
+    while (offset < _trace.length) {
+        size_t length = MGTraceEventLength(bytes[offset]);
+        if (!length || offset + length > _trace.length) {
+            return NO;
+        }
+        block(bytes + offset);
+        offset += length;
+    }
+    return YES;
+}
+
+#pragma mark - Block results
+
+- (void)applyResult:(const uint8_t *)bytes firstOnly:(BOOL)firstOnly {
+    switch (bytes[0]) {
+        case MGTraceCountEvent: {
+            MGTraceCount event;
+            memcpy(&event, bytes, sizeof(event));
+            if (!firstOnly || _count == NSNotFound) {
+                _count = event.count;
+            }
+            break;
+        }
+        case MGTraceKeyEvent: {
+            MGTraceKey event;
+            memcpy(&event, bytes, sizeof(event));
+            MGReplaySlot *slot = [self claimSlotAt:event.index seen:MGSeenKey
+                  firstOnly:firstOnly];
+            if (slot) {
+                slot->key = event.key;
+            }
+            break;
+        }
+        case MGTraceSizeEvent: {
+            MGTraceSize event;
+            memcpy(&event, bytes, sizeof(event));
+            MGReplaySlot *slot = [self claimSlotAt:event.index seen:MGSeenSize
+                  firstOnly:firstOnly];
+            if (slot) {
+                slot->size = (CGSize){event.size[0], event.size[1]};
+            }
+            break;
+        }
+        case MGTraceMarginEvent: {
+            MGTraceMargin event;
+            memcpy(&event, bytes, sizeof(event));
+            MGReplaySlot *slot = [self claimSlotAt:event.index seen:MGSeenMargin
+                  firstOnly:firstOnly];
+            if (slot) {
+                slot->margin = UIEdgeInsetsMake(event.margin[0], event.margin[1],
+                      event.margin[2], event.margin[3]);
+            }
+            break;
+        }
+        case MGTraceRowHeightEvent:
+        case MGTraceColumnWidthEvent: {
+            MGTraceDimension event;
+            memcpy(&event, bytes, sizeof(event));
+            NSMutableData *dimensions = bytes[0] == MGTraceRowHeightEvent
+                  ? _rowHeights : _columnWidths;
+            NSUInteger needed = (event.index + 1) * sizeof(MGReplayDimension);
+            if (dimensions.length < needed) {
+                dimensions.length = MAX(needed, dimensions.length * 2); // zero filled
+            }
+            MGReplayDimension *dimension = (MGReplayDimension *)dimensions.mutableBytes
+                  + event.index;
+            if (!firstOnly || !dimension->seen) {
+                dimension->seen = YES;
+                dimension->length = event.length;
+            }
+            break;
+        }
+    }
+}
+
+// the slot to write the result into, or NULL if only first results are wanted
+// and this one's been seen already
+- (MGReplaySlot *)claimSlotAt:(NSUInteger)index seen:(uint8_t)seen firstOnly:(BOOL)firstOnly {
+    NSUInteger needed = (index + 1) * sizeof(MGReplaySlot);
+    if (_slots.length < needed) {
+        _slots.length = MAX(needed, _slots.length * 2); // zero filled
+    }
+    MGReplaySlot *slot = (MGReplaySlot *)_slots.mutableBytes + index;
+    if (firstOnly) {
+        if (slot->seen & seen) {
+            return NULL;
+        }
+        slot->seen |= seen;
+    }
+    return slot;
+}
+
+- (MGReplaySlot)slotAt:(NSUInteger)index {
+    if ((index + 1) * sizeof(MGReplaySlot) > _slots.length) {
+        return (MGReplaySlot){0};
+    }
+    return ((MGReplaySlot *)_slots.bytes)[index];
+}
+
+- (CGFloat)lengthAt:(NSUInteger)index in:(NSData *)dimensions {
+    if ((index + 1) * sizeof(MGReplayDimension) > dimensions.length) {
+        return 0;
+    }
+    return ((MGReplayDimension *)dimensions.bytes)[index].length;
+}
+
+- (CGFloat)rowHeightAt:(NSUInteger)row {
+    return [self lengthAt:row in:_rowHeights];
+}
+
+- (CGFloat)columnWidthAt:(NSUInteger)column {
+    return [self lengthAt:column in:_columnWidths];
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+#pragma mark - The replay scroller
+
+- (void)applyConfig:(MGTraceConfig)config {
+    __weak MGSessionReplayer *me = self;
+    MGBoxProvider *provider = MGBoxProvider.provider;
+    __weak MGBoxProvider *weakProvider = provider;
+
+    provider.boxMaker = ^(NSString *type) {
+        return (UIView <MGLayoutBox> *)MGBox.box;
+    };
+    provider.boxCustomiser = ^(NSUInteger index) {
+        return [weakProvider boxOfType:@"Replayed"];
+    };
+    provider.counter = ^NSUInteger {
+        return me.count;
+    };
+
+    // object keys were recorded as hashes, but still replay as objects, so
+    // that the same key path is benchmarked
+    if (config.keyMode == MGTraceIntegerKeys) {
+        provider.boxIntegerKeyMaker = ^uint64_t(NSUInteger index) {
+            return [me slotAt:index].key;
+        };
+    } else if (config.keyMode == MGTraceObjectKeys) {
+        provider.boxKeyMaker = ^id(NSUInteger index) {
+            return @([me slotAt:index].key);
+        };
+    }
+    if (config.hasSizeMaker) {
+        provider.boxSizeMaker = ^CGSize(NSUInteger index) {
+            return [me slotAt:index].size;
+        };
+    }
+    if (config.hasMarginMaker) {
+        provider.boxMarginMaker = ^UIEdgeInsets(NSUInteger index) {
+            return [me slotAt:index].margin;
+        };
+    }
+    if (config.hasRowHeightMaker) {
+        provider.rowHeightMaker = ^CGFloat(NSUInteger row) {
+            return [me rowHeightAt:row];
+        };
+    }
+    if (config.hasColumnWidthMaker) {
+        provider.columnWidthMaker = ^CGFloat(NSUInteger column) {
+            return [me columnWidthAt:column];
+        };
+    }
+
+    provider.columnCount = config.columnCount;
+    provider.uniformBoxSize = (CGSize){config.uniformBoxSize[0], config.uniformBoxSize[1]};
+    provider.uniformBoxMargin = UIEdgeInsetsMake(config.uniformBoxMargin[0],
+          config.uniformBoxMargin[1], config.uniformBoxMargin[2], config.uniformBoxMargin[3]);
+
+    _scroller = [MGScrollView scrollerWithSize:CGSizeZero];
+    _scroller.contentLayoutMode = config.layoutMode;
+    _scroller.padding = UIEdgeInsetsMake(config.padding[0], config.padding[1],
+          config.padding[2], config.padding[3]);
+    _scroller.viewportMargin = (CGSize){config.viewportMargin[0], config.viewportMargin[1]};
+    _scroller.boxProvider = provider;
+}
+
+- (void)replayLayout:(MGTraceLayout)event {
+    MGScrollView *scroller = _scroller;
+    if (!scroller) {
+        return;
+    }
+
+    CGSize size = {event.containerSize[0], event.containerSize[1]};
+    if (!CGSizeEqualToSize(scroller.bounds.size, size)) {
+        scroller.frame = (CGRect){scroller.frame.origin, size};
+    }
+
+    CFTimeInterval start = CACurrentMediaTime();
+    switch (event.kind) {
+        case MGTraceAppendedLayout:
+            [scroller layoutAppendedBoxes];
+            break;
+        case MGTraceScrolledLayout: {
+            CGPoint offset = {event.contentOffset[0], event.contentOffset[1]};
+            if (CGPointEqualToPoint(scroller.contentOffset, offset)) {
+                [scroller scrollViewDidScroll:scroller];
+            } else {
+                scroller.contentOffset = offset;
+            }
+            _report.scrollCount++;
+            break;
+        }
+        default: // animated layouts are replayed without animation
+            [scroller layout];
+            break;
+    }
+    NSTimeInterval elapsed = CACurrentMediaTime() - start;
+
+    MGSessionReplayReport *report = _report;
+    report.layoutCount++;
+    report.totalTime += elapsed;
+    report.longestTime = MAX(report.longestTime, elapsed);
+    report.recordedTotalTime += event.duration;
+    report.recordedLongestTime = MAX(report.recordedLongestTime, event.duration);
+
+    uint64_t visibility = [MGSessionRecorder visibilityChecksumFor:scroller.boxProvider];
+    uint64_t frames = [MGSessionRecorder frameChecksumFor:scroller.boxProvider];
+    report.visibilityChecksum = (report.visibilityChecksum ^ visibility) * FNV_PRIME;
+    report.frameChecksum = (report.frameChecksum ^ frames) * FNV_PRIME;
+    if (visibility != event.visibilityChecksum || frames != event.frameChecksum) {
+        if (!report.mismatchCount) {
+            report.firstMismatch = report.layoutCount - 1;
+        }
+        report.mismatchCount++;
+    }
+}
+
+@end
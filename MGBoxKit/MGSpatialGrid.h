@@ -0,0 +1,36 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGBase.h"
+
+/**
+* A uniform grid of buckets for finding the objects whose frames contain a
+* point without testing every frame. Each object is added to every cell its
+* frame overlaps, so lookups only test the objects in a single cell.
+*
+* Very large frames (covering more than a few dozen cells) are kept in a
+* separate list and tested directly, to keep building the grid cheap.
+*/
+
+@interface MGSpatialGrid : NSObject
+
++ (instancetype)gridWithCellSize:(CGSize)cellSize;
+
+@property (nonatomic, readonly) CGSize cellSize;
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)addObject:(id)object withFrame:(CGRect)frame;
+- (void)removeAllObjects;
+
+/**
+* The objects whose frames contain the point, in the order they were added.
+*/
+- (NSArray *)objectsAtPoint:(CGPoint)point;
+
+/**
+* The last added object whose frame contains the point, or `nil`.
+*/
+- (id)lastObjectAtPoint:(CGPoint)point;
+
+@end
@@ -0,0 +1,114 @@
+//
+//  Created by matt on 19/10/26.
+//
+
+#import "MGSpatialGrid.h"
+
+// frames overlapping more cells than this skip the buckets
+#define MAX_CELLS_PER_FRAME 64
+
+@implementation MGSpatialGrid {
+    NSMutableDictionary *_buckets;
+    NSMutableArray *_objects;
+    NSMutableIndexSet *_oversized;
+    CGRect *_frames;
+    NSUInteger _capacity;
+}
+
++ (instancetype)gridWithCellSize:(CGSize)cellSize {
+    NSAssert(cellSize.width > 0 && cellSize.height > 0, @"Grid cells must have a size");
+    MGSpatialGrid *grid = [[self alloc] init];
+    grid->_cellSize = cellSize;
+    return grid;
+}
+
+- (id)init {
+    self = [super init];
+    _buckets = @{}.mutableCopy;
+    _objects = @[].mutableCopy;
+    _oversized = NSMutableIndexSet.indexSet;
+    return self;
+}
+
+static inline NSNumber *MGCellKey(NSInteger column, NSInteger row) {
+    return @(((int64_t)(int32_t)column << 32) | (uint32_t)(int32_t)row);
+}
+
+#pragma mark - Adding
+
+- (void)addObject:(id)object withFrame:(CGRect)frame {
+    if (!object || CGRectIsEmpty(frame) || CGRectIsNull(frame)) {
+        return;
+    }
+    if (_count == _capacity) {
+        _capacity = MAX(_capacity * 2, 16);
+        _frames = realloc(_frames, _capacity * sizeof(CGRect));
+    }
+    NSUInteger index = _count++;
+    _frames[index] = frame;
+    [_objects addObject:object];
+
+    NSInteger minColumn = (NSInteger)floor(CGRectGetMinX(frame) / _cellSize.width);
+    NSInteger maxColumn = (NSInteger)floor(CGRectGetMaxX(frame) / _cellSize.width);
+    NSInteger minRow = (NSInteger)floor(CGRectGetMinY(frame) / _cellSize.height);
+    NSInteger maxRow = (NSInteger)floor(CGRectGetMaxY(frame) / _cellSize.height);
+    if ((maxColumn - minColumn + 1) * (maxRow - minRow + 1) > MAX_CELLS_PER_FRAME) {
+        [_oversized addIndex:index];
+        return;
+    }
+
+    for (NSInteger row = minRow; row <= maxRow; row++) {
+        for (NSInteger column = minColumn; column <= maxColumn; column++) {
+            NSNumber *key = MGCellKey(column, row);
+            NSMutableIndexSet *bucket = _buckets[key];
+            if (!bucket) {
+                bucket = NSMutableIndexSet.indexSet;
+                _buckets[key] = bucket;
+            }
+            [bucket addIndex:index];
+        }
+    }
+}
+
+- (void)removeAllObjects {
+    [_buckets removeAllObjects];
+    [_objects removeAllObjects];
+    [_oversized removeAllIndexes];
+    _count = 0;
+}
+
+#pragma mark - Lookups
+
+- (NSIndexSet *)indexesAtPoint:(CGPoint)point {
+    NSMutableIndexSet *indexes = NSMutableIndexSet.indexSet;
+    NSInteger column = (NSInteger)floor(point.x / _cellSize.width);
+    NSInteger row = (NSInteger)floor(point.y / _cellSize.height);
+    NSIndexSet *bucket = _buckets[MGCellKey(column, row)];
+
+    CGRect *frames = _frames;
+    void (^test)(NSUInteger, BOOL *) = ^(NSUInteger i, BOOL *stop) {
+        if (CGRectContainsPoint(frames[i], point)) {
+            [indexes addIndex:i];
+        }
+    };
+    [bucket enumerateIndexesUsingBlock:test];
+    [_oversized enumerateIndexesUsingBlock:test];
+    return indexes;
+}
+
+- (NSArray *)objectsAtPoint:(CGPoint)point {
+    return [_objects objectsAtIndexes:[self indexesAtPoint:point]];
+}
+
+- (id)lastObjectAtPoint:(CGPoint)point {
+    NSUInteger index = [self indexesAtPoint:point].lastIndex;
+    return index == NSNotFound ? nil : _objects[index];
+}
+
+#pragma mark - Fini
+
+- (void)dealloc {
+    free(_frames);
+}
+
+@end